@@ -0,0 +1,64 @@
+// Heap use, parse time and lookup time of a 100k record document, the cost of member names.
+// Built at the parent of the interning commit it gives the before column.
+//   g++ -std=c++20 -O2 -I.. ../*.cpp key_intern.cpp -o key_intern -lz -lpthread
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+#if defined(__GLIBC__)
+#  include <malloc.h>
+#endif
+
+#include "linker_file.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+// Bytes in use on the heap, 0 where the C library does not tell
+static auto heapInUse() -> std::size_t
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+  return mallinfo2().uordblks;
+#else
+  return 0;
+#endif
+}
+
+static auto ms(Clock::time_point from, Clock::time_point to) -> double
+{
+  return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+int main()
+{
+  std::string text = "[";
+  for(int i = 0; i < 100000; i++)
+  {
+    text += (i ? "," : "");
+    text += "{\"identifier\": " + std::to_string(i) + ", \"display_name_long\": \"n\", \"price\": 1.5, "
+            "\"pair\": {\"f\": 1, \"s\": 2}, \"last_modified_timestamp\": 7}";
+  }
+  text += "]";
+
+  // One thread, so the heap and the time are those of the tree alone
+  linkerFile::setParallel(0);
+
+  const auto before = heapInUse();
+  const auto start  = Clock::now();
+
+  linkerFile file;
+  file.fromJSON(text);
+
+  const auto parsed = Clock::now();
+  const auto after  = heapInUse();
+
+  const auto  path = linkerPath::pointer("/7/last_modified_timestamp");
+  std::size_t hits = 0;
+
+  const auto finding = Clock::now();
+  for(int i = 0; i < 1000000; i++) hits += (file.find(path) != nullptr);
+  const auto found = Clock::now();
+
+  std::printf("heap %.1f MB  parse %.0f ms  1M finds %.1f ms  (%zu hits)\n", double(after - before) / 1048576.0,
+              ms(start, parsed), ms(finding, found), hits);
+  return 0;
+}
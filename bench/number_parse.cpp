@@ -0,0 +1,58 @@
+// Parse time of 100k-member documents of tokens that are not numbers, integers and decimals, and
+// the cost of reading a string as int. Built at the parent of the checked conversion commit it
+// gives the before column (without the get<int>() line, which that tree does not have).
+//   g++ -std=c++20 -O2 -I.. ../*.cpp number_parse.cpp -o number_parse -lz -lpthread
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+#include "linker_file.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+// Best of 4, in ms
+template<typename F>
+static auto best(F && run) -> double
+{
+  double ret = 1e9;
+  for(int i = 0; i < 4; i++)
+  {
+    const auto start = Clock::now();
+    run();
+    ret = std::min(ret, std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+  }
+  return ret;
+}
+
+template<typename F>
+static auto document(F && value) -> std::string
+{
+  std::string ret = "{";
+  for(int i = 0; i < 100000; i++)
+    ret += (i ? ", \"k" : "\"k") + std::to_string(i) + "\": " + value(i);
+
+  return ret + "}";
+}
+
+int main()
+{
+  const std::string tokens   = document([](int)   { return std::string("undefined"); });
+  const std::string integers = document([](int i) { return std::to_string(i * 7); });
+  const std::string decimals = document([](int i) { return std::to_string(i * 1.25); });
+
+  std::printf("tokens that are not numbers  %6.1f ms\n", best([&] { linkerFile file; file.fromJSON(tokens); }));
+  std::printf("integers                     %6.1f ms\n", best([&] { linkerFile file; file.fromJSON(integers); }));
+  std::printf("decimals                     %6.1f ms\n", best([&] { linkerFile file; file.fromJSON(decimals); }));
+
+  const linker text = linker::from(std::string("not a number"));
+  long         sum  = 0;
+
+  std::printf("1M value<int>() on a string  %6.1f ms\n", best([&] { for(int i = 0; i < 1000000; i++) sum += text.value<int>(); }));
+#if __has_include("linker_expected.hpp")
+  std::printf("1M get<int>() on a string    %6.1f ms\n", best([&] { for(int i = 0; i < 1000000; i++) sum += text.get<int>().value_or(0); }));
+#endif
+
+  // Keeps the loops from being optimized away
+  return sum == 0 ? 0 : 1;
+}
@@ -0,0 +1,86 @@
+// Save and load time and file size of 200k records of 4 fields, raw and gzip (level 1).
+//   g++ -std=c++20 -O2 -I.. ../*.cpp store_gzip.cpp -o store_gzip -lz -lpthread
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "store_settings.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+struct Record : Serializer
+{
+  int         id     = 0;
+  std::string name;
+  double      price  = 0;
+  bool        active = true;
+
+  void configPropertys(PropertyManager & manager) override
+  {
+    manager.add("id",     &this->id);
+    manager.add("name",   &this->name);
+    manager.add("price",  &this->price);
+    manager.add("active", &this->active);
+  }
+};
+
+struct Records : StoreSettings
+{
+  explicit Records(const std::string & path) : StoreSettings(path, DirectoryPath::Temp)
+  {
+    // Empty
+  }
+
+  Setting<std::vector<Record>> records { this, "records" };
+};
+
+static auto ms(Clock::time_point from, Clock::time_point to) -> double
+{
+  return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+int main()
+{
+  std::vector<Record> records(200000);
+  for(std::size_t i = 0; i < records.size(); i++)
+  {
+    records[i].id    = int(i);
+    records[i].name  = "item-" + std::to_string(i % 100);
+    records[i].price = double(i % 1000) * 0.25;
+  }
+
+  for(const auto type : { StoreCodec::Type::None, StoreCodec::Type::Gzip })
+  {
+    const std::string path = (type == StoreCodec::Type::None) ? "store_gzip_raw.json" : "store_gzip_gz.json";
+
+    double save = 0;
+    {
+      Records writer(path);
+      if(writer.setCompression(type, 1) != StoreSettings::State::OK) return 1;
+
+      const auto start = Clock::now();
+      if(writer.records.set(records) != StoreSettings::State::OK) return 1;
+      save = ms(start, Clock::now());
+    }
+
+    // Every handle is gone, the next one reads the file
+    Records reader(path);
+
+    const auto start = Clock::now();
+    const auto   read = reader.records.get();
+    const double load = ms(start, Clock::now());
+
+    if(read.size() != records.size()) return 1;
+
+    const auto bytes = fs::file_size(fs::temp_directory_path() / path);
+
+    std::printf("%-5s save %5.0f ms  load %5.0f ms  %10ju bytes\n", (type == StoreCodec::Type::None) ? "raw" : "gzip",
+                save, load, std::uintmax_t(bytes));
+
+    std::error_code error;
+    fs::remove(fs::temp_directory_path() / path, error);
+  }
+
+  return 0;
+}
@@ -0,0 +1,52 @@
+// Write and read throughput of long strings, 200 values of 84 KB with quotes and backslashes.
+// Built at the parent of the string codec commit it gives the before column.
+//   g++ -std=c++20 -O2 -I.. ../*.cpp string_codec.cpp -o string_codec -lz -lpthread
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+#include "linker_file.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+static auto seconds(Clock::time_point from, Clock::time_point to) -> double
+{
+  return std::chrono::duration<double>(to - from).count();
+}
+
+int main()
+{
+  std::string base;
+  for(int i = 0; i < 1000; i++)
+    base += "Lorem ipsum dolor sit amet, consectetur adipiscing elit {0} \"quoted\" path C:\\tmp ";
+
+  linker::array_t values;
+  for(int i = 0; i < 200; i++) values.push_back(linker::from(base + std::to_string(i)));
+
+  linkerFile file;
+  file.setJSONArray(values);
+
+  // Best of 5
+  std::string text;
+  double      write = 1e9;
+  double      read  = 1e9;
+
+  for(int run = 0; run < 5; run++)
+  {
+    const auto start = Clock::now();
+    text = file.toJSON(true);
+    const auto written = Clock::now();
+
+    linkerFile copy;
+    copy.fromJSON(text);
+    const auto parsed = Clock::now();
+
+    write = std::min(write, seconds(start, written));
+    read  = std::min(read,  seconds(written, parsed));
+  }
+
+  const double mb = double(text.size()) / 1e6;
+  std::printf("%.1f MB  write %.0f MB/s  read %.0f MB/s\n", mb, mb / write, mb / read);
+  return 0;
+}
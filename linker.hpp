@@ -1,9 +1,16 @@
 #pragma once
 
+#include <algorithm>
 #include <any>
+#include <atomic>
+#include <cstdint>
 #include <cstring>
 #include <optional>
+#include <utility>
 
+#include "linker_expected.hpp"
+#include "linker_key.hpp"
+#include "linker_path.hpp"
 #include "type_traits.hpp"
 
 class linker;
@@ -18,7 +25,7 @@ template<typename T>        constexpr bool is_linker_v = is_linker<T>::value;
 template<typename T, typename U = void>
 struct is_linker_obj : std::false_type {};
 template<>
-struct is_linker_obj<std::map<std::string, linker>> : std::true_type {};
+struct is_linker_obj<std::map<linkerKey, linker, std::less<>>> : std::true_type {};
 template<typename T>        constexpr bool is_linker_obj_v = is_linker_obj<T>::value;
 
 // linker_arr
@@ -29,6 +36,16 @@ struct is_linker_arr<std::vector<linker>> : std::true_type {};
 template<typename T>
 constexpr bool is_linker_arr_v = is_linker_arr<T>::value;
 
+// Containers of plain numbers, stored contiguously as linker::packed_t
+template<typename T, typename U = void>
+struct is_packable : std::false_type {};
+template<typename T>
+struct is_packable<T, std::enable_if_t<is_vector_v<T> || is_array_v<T> || is_valarray_v<T> || is_deque_v<T>>>
+  : std::bool_constant<std::is_arithmetic_v<typename T::value_type>
+                    && !std::is_same_v<typename T::value_type, bool>> {};
+template<typename T>
+constexpr bool is_packable_v = is_packable<T>::value;
+
 class linker
 {
   template<std::size_t I, class T>
@@ -51,7 +68,21 @@ public:
   using number_t = long double;
   using string_t = std::string;
   using array_t  = std::vector<linker>;
-  using object_t = std::map<std::string, linker>;
+  using object_t = std::map<linkerKey, linker, std::less<>>;
+  using packed_t = std::variant<std::vector<int8_t>,  std::vector<uint8_t>,
+                                std::vector<int16_t>, std::vector<uint16_t>,
+                                std::vector<int32_t>, std::vector<uint32_t>,
+                                std::vector<int64_t>, std::vector<uint64_t>,
+                                std::vector<float>,   std::vector<double>,
+                                std::vector<long double>>;
+
+  // Element type a number is packed as, same size and signedness
+  template<typename T>
+  using packed_elem_t = std::conditional_t<std::is_floating_point_v<T>, T,
+    std::conditional_t<sizeof(T) == 1, std::conditional_t<std::is_signed_v<T>, int8_t,  uint8_t>,
+    std::conditional_t<sizeof(T) == 2, std::conditional_t<std::is_signed_v<T>, int16_t, uint16_t>,
+    std::conditional_t<sizeof(T) == 4, std::conditional_t<std::is_signed_v<T>, int32_t, uint32_t>,
+                                       std::conditional_t<std::is_signed_v<T>, int64_t, uint64_t>>>>>;
 
   auto operator<<(const Serializer & value) -> linker &;
   auto operator>>(Serializer & retVal) const -> Serializer &;
@@ -73,11 +104,21 @@ public:
       for(std::size_t i = 0; i < arr.size(); i++)
         arr[i] = linker::from(value[i]);
 
-      this->m_value = std::move(arr);
+      this->store(std::move(arr));
+    }
+    else if constexpr (is_packable_v<T>)
+    {
+      using elem_t = packed_elem_t<typename T::value_type>;
+
+      std::vector<elem_t> arr(std::size(value));
+      std::transform(std::begin(value), std::end(value), arr.begin(),
+                     [](auto number) { return static_cast<elem_t>(number); });
+
+      this->store(packed_t(std::move(arr)));
     }
     else if constexpr (is_linker_obj_v<std::remove_const_t<T>>)
     {
-      this->m_value = std::move(value);
+      this->store(object_t(value));
     }
     else if constexpr (is_vector_v<T> || is_list_v<T>     || is_forward_list_v<T>
                     || is_set_v<T>    || is_multiset_v<T> || is_unordered_set_v<T>
@@ -95,12 +136,12 @@ public:
         *it = linker::from(*inIt);
       }
 
-      this->m_value = std::move(arr);
+      this->store(std::move(arr));
     }
     else if constexpr (is_pair_v<T>)
     {
-      this->m_value = object_t { { "f", linker::from(value.first) },
-                                 { "s", linker::from(value.second) } };
+      this->store(object_t { { "f", linker::from(value.first) },
+                             { "s", linker::from(value.second) } });
     }
     else if constexpr (is_bitset_v<T>)
     {
@@ -109,7 +150,7 @@ public:
       for(std::size_t i = 0; i < value.size(); i++)
         arr[i] << value[i];
 
-      this->m_value = std::move(arr);
+      this->store(std::move(arr));
     }
     else if constexpr (is_queue_v<T> || is_priority_queue_v<T> || is_stack_v<T>)
     {
@@ -134,12 +175,12 @@ public:
         }
       }
 
-      this->m_value = std::move(arr);
+      this->store(std::move(arr));
     }
     else if constexpr (is_complex_v<T>)
     {
-      this->m_value = object_t { { "r", linker::from(value.real()) },
-                                 { "i", linker::from(value.imag()) } };
+      this->store(object_t { { "r", linker::from(value.real()) },
+                             { "i", linker::from(value.imag()) } });
     }
     else if constexpr (is_tuple_v<T>)
     {
@@ -150,7 +191,7 @@ public:
           [](auto && ...){}((obj["t" + std::to_string(I)] << std::get<I>(value))...);
       }(std::make_index_sequence<std::tuple_size_v<T>>());
 
-      this->m_value = std::move(obj);
+      this->store(std::move(obj));
     }
     else if constexpr (is_variant_v<T>)
     {
@@ -158,8 +199,8 @@ public:
       {
           [&](auto && ...){}((I == value.index() ? [&]<typename V>(V && value)
           {
-              this->m_value = object_t { { "i", linker::from(I) },
-                                         { "v", linker::from(std::any_cast<V>(value)) } };
+              this->store(object_t { { "i", linker::from(I) },
+                                     { "v", linker::from(std::any_cast<V>(value)) } });
               return std::nullopt;
           } (std::get<I>(value)) : std::nullopt)...);
       }(std::make_index_sequence<std::variant_size_v<T>>());
@@ -177,87 +218,314 @@ public:
     return *this;
   }
 
+  // Why a checked conversion or a parse failed
+  struct Error
+  {
+    enum class Code : uint8_t
+    {
+      TypeMismatch,
+      MissingKey,
+      Parse
+    };
+
+    Code        code = Code::TypeMismatch;
+    // JSON pointer to the node that failed, relative to where the conversion started
+    std::string path {};
+    // Position in the text for Parse errors
+    std::size_t offset = std::string::npos;
+  };
+  template<class T>
+  using expected_t = linkerExpected<T, Error>;
+
+  // Lenient conversion, whatever does not match T is left default constructed
+  template<class T>
+  [[nodiscard]] auto value() const & -> T
+  {
+    T retVal {};
+    *this >> retVal;
+    return retVal;
+  }
+  // Consuming conversion, strings and child nodes are moved out of the tree
   template<class T>
-  [[nodiscard]] auto value() const -> T
+  [[nodiscard]] auto value() && -> T
   {
-    try
+    T retVal {};
+    std::move(*this) >> retVal;
+    return retVal;
+  }
+
+  // Checked conversion, fails on the first node (element, pair or tuple member, ...) that
+  // does not hold what T reads from it. Nothing is thrown, the tree is walked once more
+  template<class T>
+  [[nodiscard]] auto get() const & -> expected_t<T>
+  {
+    if(auto error = linker::check<T>(*this))
+      return linkerUnexpected<Error>(std::move(*error));
+
+    T retVal {};
+    *this >> retVal;
+    return retVal;
+  }
+  template<class T>
+  [[nodiscard]] auto get() && -> expected_t<T>
+  {
+    if(auto error = linker::check<T>(*this))
+      return linkerUnexpected<Error>(std::move(*error));
+
+    T retVal {};
+    std::move(*this) >> retVal;
+    return retVal;
+  }
+
+  template<class T>
+  auto operator>>(T & retVal) const & -> T &
+  {
+    return linker::convert(*this, retVal);
+  }
+  template<class T>
+  auto operator>>(T & retVal) && -> T &
+  {
+    return linker::convert(std::move(*this), retVal);
+  }
+
+  [[nodiscard]] inline auto type() const -> Types { return this->m_type; }
+
+  // Same JSON once written, packed and regular arrays of equal numbers compare equal
+  [[nodiscard]] auto operator==(const linker & other) const -> bool;
+
+  [[nodiscard]] inline auto isPacked() const -> bool
+  {
+    return this->peek<packed_t>() != nullptr;
+  }
+  [[nodiscard]] static auto packed(packed_t values) -> linker
+  {
+    linker ret;
+    ret.m_type  = Types::Array;
+    ret.store(std::move(values));
+    return ret;
+  }
+  // Turns a packed array into a regular array of nodes
+  void unpack()
+  {
+    if(const auto * pPacked = this->peek<packed_t>())
+    {
+      array_t arr;
+      this->store(std::move(linker::expand(*pPacked, arr)));
+    }
+  }
+
+  // In-place access to children, nothing is copied out of the tree
+  [[nodiscard]] auto find(const std::string & key) const -> const linker *
+  {
+    const auto * pObj = this->peek<object_t>();
+    if(pObj == nullptr) return nullptr;
+
+    auto it = pObj->find(key);
+    return it != pObj->end() ? &it->second : nullptr;
+  }
+  // Elements of a packed array have no node of their own, unpack() it first
+  [[nodiscard]] auto find(std::size_t index) const -> const linker *
+  {
+    const auto * pArr = this->peek<array_t>();
+    return (pArr != nullptr && index < pArr->size()) ? &(*pArr)[index] : nullptr;
+  }
+
+  // Child for writing, the node becomes an object (or grows as an array) when needed.
+  // Storage shared with a copy of this node is duplicated first, the copy never changes
+  auto child(const std::string & key) -> linker &
+  {
+    if(this->peek<object_t>() == nullptr)
     {
-      T retVal;
-      return *this >> retVal;
+      this->m_type = Types::Object;
+      this->store(object_t());
     }
-    catch(...)
+    return (*this->write<object_t>())[key];
+  }
+  auto child(std::size_t index) -> linker &
+  {
+    this->unpack();
+
+    if(this->peek<array_t>() == nullptr)
     {
-      return {};
+      this->m_type = Types::Array;
+      this->store(array_t());
     }
+
+    auto & arr = *this->write<array_t>();
+    if(index >= arr.size()) arr.resize(index + 1);
+
+    return arr[index];
+  }
+
+  template<typename T>
+    static inline auto value(const linker & lnk) -> T
+  {
+    return lnk.value<T>();
+  }
+  template<typename T>
+    static inline auto value(linker && lnk) -> T
+  {
+    return std::move(lnk).value<T>();
+  }
+  template<typename T>
+  static inline auto from(const T & value) -> linker
+  {
+    return linker() << value;
   }
 
+private:
   template<class T>
-  auto operator>>(T & retVal) const -> T &
+  static constexpr auto get_type() -> Types
   {
-    try
-    {
-    constexpr Types m_type = linker::get_type<T>();
+    if constexpr (std::is_null_pointer_v<T>)
+        return Types::Null;
+    else if constexpr (std::is_same_v<std::decay_t<T>, bool_t>)
+        return Types::Bool;
+    else if constexpr (std::is_enum_v<T> || std::is_arithmetic_v<T>)
+        return Types::Number;
+    else if constexpr (std::is_convertible_v<T, string_t>)
+        return Types::String;
+    else if constexpr (is_linker_obj_v<T> || is_pair_v<T> || is_complex_v<T>
+                    || is_tuple_v<T> || is_variant_v<T> || std::is_base_of_v<Serializer, T>)
+        return Types::Object;
+    else if constexpr (is_linker_arr_v<T> || std::is_array_v<T> || is_array_v<T> || is_bitset_v<T>
+                    || is_vector_v<T> || is_list_v<T> || is_forward_list_v<T> || is_set_v<T>
+                    || is_multiset_v<T> || is_unordered_set_v<T> || is_unordered_multiset_v<T>
+                    || is_valarray_v<T> || is_map_v<T> || is_multimap_v<T> || is_unordered_map_v<T>
+                    || is_unordered_multimap_v<T> || is_bitset_v<T> || is_deque_v<T> || is_queue_v<T>
+                    || is_priority_queue_v<T> || is_stack_v<T>)
+        return Types::Array;
+    else return Types::Other;
+  }
 
-    if constexpr      (m_type == Types::Bool)   retVal = this->cast<bool_t>();
-    else if constexpr (m_type == Types::Number) retVal = (T)this->cast<number_t>();
+  // Body of both operator>> overloads, Self is linker when the node is consumed
+  template<class Self, class T>
+  static auto convert(Self && self, T & retVal) -> T &
+  {
+    constexpr bool  consume = std::is_same_v<Self, linker>;
+    constexpr Types m_type  = linker::get_type<T>();
+
+    if constexpr      (m_type == Types::Bool)   retVal = self.template cast<bool_t>();
+    else if constexpr (m_type == Types::Number) retVal = (T)self.template cast<number_t>();
     else if constexpr (m_type == Types::String)
     {
-      const auto string = this->cast<string_t>();
+      if constexpr (consume && std::is_same_v<T, string_t>)
+      {
+        auto * pString = self.template write<string_t>();
+
+        if(pString) retVal = std::move(*pString);
+        else        retVal.clear();
+
+        return retVal;
+      }
+
+      const auto & string = self.template ref<string_t>();
 
       if constexpr (std::is_array_v<T>)
       {
         strncpy(retVal, string.c_str(), std::extent_v<T>);
         retVal[std::extent_v<T> - 1] = '\0';
       }
+      else if constexpr (std::is_same_v<T, string_t>)
+      {
+        retVal.assign(string);
+      }
       else
       {
-        retVal = this->cast<string_t>().c_str();
+        retVal = string.c_str();
       }
     }
     else if constexpr (std::is_array_v<T>)
     {
-      const array_t arr { this->cast<array_t>() };
+      array_t scratch;
+      auto && arr = self.items(scratch);
 
       for(std::size_t i = 0; i < std::extent_v<T> && i < arr.size(); i++)
-        arr[i] >> retVal[i];
+        linker::pass<consume>(arr[i]) >> retVal[i];
     }
-    else if constexpr (is_array_v<T>)
+    else if constexpr (is_packable_v<T>)
     {
-      const array_t arr { this->cast<array_t>() };
-      T ret;
+      if(const auto * pPacked = self.template peek<packed_t>())
+      {
+        linker::unpack(*pPacked, retVal);
+        return retVal;
+      }
+
+      array_t scratch;
+      auto && arr = self.items(scratch);
 
-      for(std::size_t i = 0; i < ret.size() && i < arr.size(); i++)
-        arr[i] >> ret[i];
+      if constexpr (is_array_v<T>)
+      {
+        for(std::size_t i = 0; i < retVal.size(); i++)
+        {
+          if(i < arr.size()) linker::pass<consume>(arr[i]) >> retVal[i];
+          else               retVal[i] = {};
+        }
+      }
+      else
+      {
+        if constexpr (is_valarray_v<T>)
+        {
+          if(retVal.size() != arr.size()) retVal.resize(arr.size());
+        }
+        else retVal.resize(arr.size());
 
-      std::swap(retVal, ret);
+        auto retIt = std::begin(retVal);
+        for(auto it = std::begin(arr); it != std::end(arr); it++, retIt++)
+          linker::pass<consume>(*it) >> *retIt;
+      }
+    }
+    else if constexpr (is_array_v<T>)
+    {
+      array_t scratch;
+      auto && arr = self.items(scratch);
+
+      for(std::size_t i = 0; i < retVal.size(); i++)
+      {
+        if(i < arr.size()) linker::pass<consume>(arr[i]) >> retVal[i];
+        else               retVal[i] = {};
+      }
     }
     else if constexpr (is_vector_v<T>   || is_list_v<T> || is_forward_list_v<T>
                     || is_valarray_v<T> || is_deque_v<T>)
     {
-      const array_t arr { this->cast<array_t>() };
-      T ret(arr.size());
+      // Converts into the caller's elements, so their storage is reused
+      array_t scratch;
+      auto && arr = self.items(scratch);
 
-      auto retIt = std::begin(ret);
-      for(auto it = std::cbegin(arr); it != std::cend(arr); it++, retIt++)
+      if constexpr (is_valarray_v<T>)
       {
-        *it >> *retIt;
+        if(retVal.size() != arr.size()) retVal.resize(arr.size());
       }
+      else retVal.resize(arr.size());
 
-      std::swap(retVal, ret);
+      auto retIt = std::begin(retVal);
+      for(auto it = std::begin(arr); it != std::end(arr); it++, retIt++)
+      {
+        linker::pass<consume>(*it) >> *retIt;
+      }
     }
     else if constexpr (is_linker_obj_v<std::remove_const_t<T>>)
     {
-      retVal = this->cast<linker::object_t>();
+      if constexpr (consume)
+      {
+        auto * pObj = self.template write<object_t>();
+
+        if(pObj) retVal = std::move(*pObj);
+        else     retVal.clear();
+      }
+      else retVal = self.template ref<object_t>();
     }
     else if constexpr (is_set_v<T> || is_multiset_v<T> || is_unordered_set_v<T>
                     || is_unordered_multiset_v<T>      || is_multimap_v<T>
                     || is_map_v<T> || is_unordered_multimap_v<T>
                     || is_unordered_map_v<T>)
     {
-      T ret;
-      const array_t arr { this->cast<array_t>() };
+      array_t scratch;
+      auto && arr = self.items(scratch);
 
-      for(auto it = std::cbegin(arr); it != std::cend(arr); it++)
+      retVal.clear();
+      for(auto it = std::begin(arr); it != std::end(arr); it++)
       {
         if constexpr (is_map_v<T> || is_multimap_v<T> || is_unordered_map_v<T>
                     || is_unordered_multimap_v<T>)
@@ -265,138 +533,417 @@ public:
           using first  = std::remove_const_t<typename T::key_type>;
           using second = std::remove_const_t<typename T::mapped_type>;
 
-          ret.insert(it->value<std::pair<first, second>>());
+          retVal.insert(linker::value<std::pair<first, second>>(linker::pass<consume>(*it)));
         }
         else
         {
-          ret.insert(it->value<typename T::value_type>());
+          retVal.insert(linker::value<typename T::value_type>(linker::pass<consume>(*it)));
         }
       }
-
-      std::swap(retVal, ret);
     }
     else if constexpr (is_pair_v<T>)
     {
-      object_t obj { this->cast<object_t>() };
-
       using first  = std::remove_const_t<typename T::first_type>;
       using second = std::remove_const_t<typename T::second_type>;
 
-      retVal = { std::move(obj["f"].value<first>()), std::move(obj["s"].value<second>()) };
+      retVal = { linker::value<first>(linker::member(std::forward<Self>(self), "f")),
+                 linker::value<second>(linker::member(std::forward<Self>(self), "s")) };
     }
     else if constexpr (is_bitset_v<T>)
     {
-      const array_t arr { this->cast<array_t>() };
+      array_t scratch;
+      auto && arr = self.items(scratch);
 
       for(std::size_t i = 0; i < arr.size() && i < retVal.size(); i++)
-        retVal[i] = arr[i].value<bool>();
+        retVal[i] = arr[i].template value<bool>();
     }
     else if constexpr (is_queue_v<T> || is_priority_queue_v<T> || is_stack_v<T>)
     {
       T ret;
-      const array_t arr { this->cast<array_t>() };
+      array_t scratch;
+      auto && arr = self.items(scratch);
 
       for(auto & cell : arr)
-        ret.push(cell.value<typename T::value_type>());
+        ret.push(linker::value<typename T::value_type>(linker::pass<consume>(cell)));
 
       retVal.swap(ret);
     }
     else if constexpr (is_complex_v<T>)
     {
-      object_t obj { this->cast<object_t>() };
-
-      retVal->real(obj["r"].value<number_t>());
-      retVal->imag(obj["i"].value<number_t>());
+      retVal.real(linker::value<typename T::value_type>(linker::member(std::forward<Self>(self), "r")));
+      retVal.imag(linker::value<typename T::value_type>(linker::member(std::forward<Self>(self), "i")));
     }
     else if constexpr (is_tuple_v<T>)
     {
-      object_t obj { this->cast<object_t>() };
       [&]<std::size_t ... I>(std::index_sequence<I ...>)
       {
-        [](auto && ...){}(obj["t" + std::to_string(I)] >> std::get<I>(retVal)...);
+        [](auto && ...){}(linker::member(std::forward<Self>(self), "t" + std::to_string(I))
+                          >> std::get<I>(retVal)...);
       }(std::make_index_sequence<std::tuple_size_v<T>>());
     }
     else if constexpr (is_variant_v<T>)
     {
+      const auto index = linker::value<std::size_t>(linker::member(self, "i"));
+
       [&]<std::size_t ... I>(std::index_sequence<I ...>)
       {
-        auto obj = this->cast<object_t>();
-        [](auto && ...){}((I == obj["i"].value<std::size_t>() ? [&]
+        [](auto && ...){}((I == index ? [&]
         {
-          retVal = obj["v"].value<std::variant_alternative_t<I, T>>();
+          retVal = linker::value<std::variant_alternative_t<I, T>>(
+                     linker::member(std::forward<Self>(self), "v"));
           return std::nullopt;
         }() : std::nullopt)...);
       }(std::make_index_sequence<std::variant_size_v<T>>());
     }
     else if constexpr (is_linker_v<T>)
     {
-      retVal = this->cast<linker>();
+      retVal = std::forward<Self>(self);
     }
     else if(std::is_base_of_v<Serializer, T>)
     {
-      this->operator>>(*(Serializer*)&retVal);
-    }
+      self.operator>>(*(Serializer*)&retVal);
     }
-    catch(...) { }
 
     return retVal;
   }
 
-  [[nodiscard]] inline auto type() const -> Types { return this->m_type; }
+  // What get<T>() reports for node, nullopt when T reads it faithfully
+  template<class T>
+  static auto check(const linker & node) -> std::optional<Error>
+  {
+    constexpr Types m_type = linker::get_type<T>();
 
-  template<typename T>
-    static inline auto value(const linker & lnk) -> T
+    if constexpr (is_linker_v<T> || m_type == Types::Other)
+    {
+      return std::nullopt;
+    }
+    else
+    {
+      if(node.m_type == Types::Other) return Error { Error::Code::MissingKey };
+      if(node.m_type != m_type)       return Error { Error::Code::TypeMismatch };
+
+      if constexpr (m_type == Types::Array && !is_linker_arr_v<T>)
+      {
+        using elem_t = typename linker::elem<T>::type;
+
+        if(const auto * pPacked = node.peek<packed_t>())
+        {
+          if constexpr (get_type<elem_t>() == Types::Number || get_type<elem_t>() == Types::Other)
+          {
+            return std::nullopt;
+          }
+          else
+          {
+            const bool empty = std::visit([](const auto & values) { return values.empty(); }, *pPacked);
+            return empty ? std::nullopt : std::optional<Error>(Error { Error::Code::TypeMismatch, "/0" });
+          }
+        }
+
+        const auto & arr = node.ref<array_t>();
+        for(std::size_t i = 0; i < arr.size(); i++)
+        {
+          if(auto error = linker::check<elem_t>(arr[i]))
+          {
+            error->path.insert(0, "/" + std::to_string(i));
+            return error;
+          }
+        }
+      }
+      else if constexpr (is_pair_v<T>)
+      {
+        if(auto error = linker::checkMember<std::remove_const_t<typename T::first_type>>(node, "f"))
+          return error;
+        return linker::checkMember<typename T::second_type>(node, "s");
+      }
+      else if constexpr (is_complex_v<T>)
+      {
+        if(auto error = linker::checkMember<typename T::value_type>(node, "r"))
+          return error;
+        return linker::checkMember<typename T::value_type>(node, "i");
+      }
+      else if constexpr (is_tuple_v<T>)
+      {
+        std::optional<Error> error;
+
+        [&]<std::size_t ... I>(std::index_sequence<I ...>)
+        {
+          (void)((error = linker::checkMember<std::tuple_element_t<I, T>>(node, "t" + std::to_string(I)))
+                 || ...);
+        }(std::make_index_sequence<std::tuple_size_v<T>>());
+
+        return error;
+      }
+      else if constexpr (is_variant_v<T>)
+      {
+        if(auto error = linker::checkMember<std::size_t>(node, "i"))
+          return error;
+
+        const auto index = node.find("i")->template value<std::size_t>();
+        if(index >= std::variant_size_v<T>)
+          return Error { Error::Code::TypeMismatch, "/i" };
+
+        std::optional<Error> error;
+
+        [&]<std::size_t ... I>(std::index_sequence<I ...>)
+        {
+          (void)((I == index && (error = linker::checkMember<std::variant_alternative_t<I, T>>(node, "v")))
+                 || ...);
+        }(std::make_index_sequence<std::variant_size_v<T>>());
+
+        return error;
+      }
+      return std::nullopt;
+    }
+  }
+
+  template<class T>
+  static auto checkMember(const linker & node, const std::string & key) -> std::optional<Error>
   {
-    return lnk.value<T>();
+    const linker * pNode = node.find(key);
+
+    auto error = pNode ? linker::check<T>(*pNode) : std::optional<Error>(Error { Error::Code::MissingKey });
+    if(error) error->path.insert(0, linkerPath::key(key).toPointer());
+
+    return error;
   }
-  template<typename T>
-  static inline auto from(const T & value) -> linker
+
+  // Element type an array-like T reads, maps are stored as arrays of pairs
+  template<class T, class U = void>
+  struct elem
   {
-    return linker() << value;
+    using type = typename T::value_type;
+  };
+  template<class T>
+  struct elem<T, std::enable_if_t<std::is_array_v<T>>>
+  {
+    using type = std::remove_extent_t<T>;
+  };
+  template<class T>
+  struct elem<T, std::enable_if_t<is_bitset_v<T>>>
+  {
+    using type = bool;
+  };
+  template<class T>
+  struct elem<T, std::enable_if_t<is_map_v<T> || is_multimap_v<T> || is_unordered_map_v<T>
+                               || is_unordered_multimap_v<T>>>
+  {
+    using type = std::pair<std::remove_const_t<typename T::key_type>, typename T::mapped_type>;
+  };
+
+  template<bool consume, class U>
+  static auto pass(U & node) -> std::conditional_t<consume, U &&, const U &>
+  {
+    if constexpr (consume) return std::move(node);
+    else                   return node;
   }
 
-private:
+  // Child of an object node, moved out when the parent is being consumed
+  template<class Self>
+  static auto member(Self && self, const std::string & key) -> decltype(auto)
+  {
+    if constexpr (std::is_same_v<Self, linker>)
+    {
+      auto * pObj = self.template write<object_t>();
+      auto   it   = pObj ? pObj->find(key) : object_t::iterator();
+
+      return (pObj && it != pObj->end()) ? std::move(it->second) : linker();
+    }
+    else
+    {
+      const linker * pNode = self.find(key);
+      return pNode ? *pNode : linker::none();
+    }
+  }
+
+  static auto none() -> const linker &
+  {
+    static const linker empty;
+    return empty;
+  }
+
+  static auto expand(const packed_t & packed, array_t & arr) -> array_t &
+  {
+    std::visit([&arr](const auto & values)
+    {
+      arr.resize(values.size());
+      for(std::size_t i = 0; i < values.size(); i++)
+        arr[i] << values[i];
+    }, packed);
+
+    return arr;
+  }
+
+  // Bulk copy out of a packed array, a plain memory copy when the element types match
   template<class T>
-  static constexpr auto get_type() -> Types
+  static void unpack(const packed_t & packed, T & retVal)
   {
-    if constexpr (std::is_null_pointer_v<T>)
-        return Types::Null;
-    else if constexpr (std::is_same_v<std::decay_t<T>, bool_t>)
-        return Types::Bool;
-    else if constexpr (std::is_enum_v<T> || std::is_arithmetic_v<T>)
-        return Types::Number;
-    else if constexpr (std::is_convertible_v<T, string_t>)
-        return Types::String;
-    else if constexpr (is_linker_obj_v<T> || is_pair_v<T> || is_complex_v<T>
-                    || is_tuple_v<T> || is_variant_v<T> || std::is_base_of_v<Serializer, T>)
-        return Types::Object;
-    else if constexpr (is_linker_arr_v<T> || std::is_array_v<T> || is_array_v<T> || is_bitset_v<T>
-                    || is_vector_v<T> || is_list_v<T> || is_forward_list_v<T> || is_set_v<T>
-                    || is_multiset_v<T> || is_unordered_set_v<T> || is_unordered_multiset_v<T>
-                    || is_valarray_v<T> || is_map_v<T> || is_multimap_v<T> || is_unordered_map_v<T>
-                    || is_unordered_multimap_v<T> || is_bitset_v<T> || is_deque_v<T> || is_queue_v<T>
-                    || is_priority_queue_v<T> || is_stack_v<T>)
-        return Types::Array;
-    else return Types::Other;
+    using elem_t = typename T::value_type;
+
+    std::visit([&retVal](const auto & values)
+    {
+      auto convert = [](auto number) { return static_cast<elem_t>(number); };
+
+      if constexpr (is_array_v<T>)
+      {
+        const std::size_t count = std::min(retVal.size(), values.size());
+
+        std::transform(values.begin(), values.begin() + count, retVal.begin(), convert);
+        std::fill(retVal.begin() + count, retVal.end(), elem_t());
+      }
+      else
+      {
+        if constexpr (is_valarray_v<T>)
+        {
+          if(retVal.size() != values.size()) retVal.resize(values.size());
+        }
+        else retVal.resize(values.size());
+
+        std::transform(values.begin(), values.end(), std::begin(retVal), convert);
+      }
+    }, packed);
+  }
+
+  // Elements of an array node, a packed array is expanded into scratch
+  auto items(array_t & scratch) const -> const array_t &
+  {
+    if(const auto * pArr = this->peek<array_t>())
+      return *pArr;
+
+    if(const auto * pPacked = this->peek<packed_t>())
+      return linker::expand(*pPacked, scratch);
+
+    return scratch;
+  }
+
+  auto items(array_t & scratch) -> array_t &
+  {
+    if(auto * pArr = this->write<array_t>())
+      return *pArr;
+
+    if(const auto * pPacked = this->peek<packed_t>())
+      return linker::expand(*pPacked, scratch);
+
+    return scratch;
+  }
+
+  template<class T>
+  [[nodiscard]] auto ref() const -> const T &
+  {
+    static const T empty {};
+
+    const T * pValue = this->peek<T>();
+    return pValue ? *pValue : empty;
   }
 
   template<class T>
   [[nodiscard]] auto cast() const -> T
   {
-    try
+    const T * pValue = this->peek<T>();
+    return pValue ? *pValue : T {};
+  }
+
+  // Containers are reference counted, copying a node (or a whole document)
+  // shares them and the first write through either side detaches its own copy.
+  // One pointer wide, so std::any keeps it inline and a copy never allocates
+  template<class T>
+  class shared
+  {
+    struct box
+    {
+      std::atomic<std::size_t> refs;
+      T                        value;
+    };
+    box * pBox;
+
+  public:
+    explicit shared(T value) : pBox(new box { 1, std::move(value) })
+    {
+      // Empty
+    }
+    ~shared()
+    {
+      if(this->pBox && this->pBox->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        delete this->pBox;
+    }
+    shared(const shared & other) noexcept : pBox(other.pBox)
+    {
+      this->pBox->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+    shared(shared && other) noexcept : pBox(std::exchange(other.pBox, nullptr))
+    {
+      // Empty
+    }
+    auto operator=(shared other) noexcept -> shared &
+    {
+      std::swap(this->pBox, other.pBox);
+      return *this;
+    }
+
+    [[nodiscard]] inline auto get() const -> T * { return &this->pBox->value; }
+    [[nodiscard]] inline auto unique() const -> bool
+    {
+      return this->pBox->refs.load(std::memory_order_acquire) == 1;
+    }
+  };
+
+  template<class T>
+  static constexpr bool is_shared_v = std::is_same_v<T, array_t> || std::is_same_v<T, object_t>
+                                   || std::is_same_v<T, packed_t>;
+
+  template<class T>
+  [[nodiscard]] auto peek() const -> const T *
+  {
+    if constexpr (is_shared_v<T>)
     {
-      return std::any_cast<T>(this->m_value);
+      const auto * pShared = std::any_cast<shared<T>>(&this->m_value);
+      return pShared ? pShared->get() : nullptr;
     }
-    catch(...)
+    else return std::any_cast<T>(&this->m_value);
+  }
+
+  // find() for writing, the node's storage is detached before the child is handed out
+  [[nodiscard]] auto locate(const std::string & key) -> linker *
+  {
+    auto * pObj = this->write<object_t>();
+    if(pObj == nullptr) return nullptr;
+
+    auto it = pObj->find(key);
+    return it != pObj->end() ? &it->second : nullptr;
+  }
+  [[nodiscard]] auto locate(std::size_t index) -> linker *
+  {
+    auto * pArr = this->write<array_t>();
+    return (pArr != nullptr && index < pArr->size()) ? &(*pArr)[index] : nullptr;
+  }
+
+  template<class T>
+  [[nodiscard]] auto write() -> T *
+  {
+    if constexpr (is_shared_v<T>)
     {
-      return {};
+      auto * pShared = std::any_cast<shared<T>>(&this->m_value);
+      if(pShared == nullptr) return nullptr;
+
+      if(!pShared->unique())
+        *pShared = shared<T>(*pShared->get());
+
+      return pShared->get();
     }
+    else return std::any_cast<T>(&this->m_value);
+  }
+
+  template<class T>
+  void store(T value)
+  {
+    if constexpr (is_shared_v<T>) this->m_value = shared<T>(std::move(value));
+    else                          this->m_value = std::move(value);
   }
 
   Types m_type = Types::Other;
   std::any m_value = std::nullopt;
 
   friend class linkerFile;
+  friend class StoreShm;
 };
 
 void operator>>(const linker::object_t & map, Serializer * object);
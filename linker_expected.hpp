@@ -0,0 +1,88 @@
+#pragma once
+
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <version>
+
+#if defined(__cpp_lib_expected) && __cpp_lib_expected >= 202202L
+#  include <expected>
+
+template<class T, class E> using linkerExpected   = std::expected<T, E>;
+template<class E>          using linkerUnexpected = std::unexpected<E>;
+#else
+// Error handed to linkerExpected to select its failed state, like std::unexpected
+template<class E>
+class linkerUnexpected
+{
+  E m_error;
+
+public:
+  explicit linkerUnexpected(E error) : m_error(std::move(error))
+  {
+    // Empty
+  }
+
+  [[nodiscard]] inline auto error() &       -> E &       { return this->m_error; }
+  [[nodiscard]] inline auto error() const & -> const E & { return this->m_error; }
+  [[nodiscard]] inline auto error() &&      -> E &&      { return std::move(this->m_error); }
+};
+
+// The part of std::expected (C++23) the library uses, for standard libraries without it.
+// value() and operator* require a value, error() requires an error
+template<class T, class E>
+class linkerExpected
+{
+  std::variant<T, E> m_value;
+
+public:
+  using value_type = T;
+  using error_type = E;
+
+  linkerExpected() : m_value(std::in_place_index<0>)
+  {
+    // Empty
+  }
+  template<class U = T>
+    requires (std::is_constructible_v<T, U &&>
+          && !std::is_same_v<std::remove_cvref_t<U>, linkerExpected>
+          && !std::is_same_v<std::remove_cvref_t<U>, linkerUnexpected<E>>)
+  linkerExpected(U && value) : m_value(std::in_place_index<0>, std::forward<U>(value))
+  {
+    // Empty
+  }
+  template<class G>
+  linkerExpected(linkerUnexpected<G> error) : m_value(std::in_place_index<1>, std::move(error).error())
+  {
+    // Empty
+  }
+
+  [[nodiscard]] inline auto has_value() const -> bool { return this->m_value.index() == 0; }
+  [[nodiscard]] inline explicit operator bool() const { return this->has_value(); }
+
+  [[nodiscard]] inline auto value() &       -> T &       { return *std::get_if<0>(&this->m_value); }
+  [[nodiscard]] inline auto value() const & -> const T & { return *std::get_if<0>(&this->m_value); }
+  [[nodiscard]] inline auto value() &&      -> T &&      { return std::move(*std::get_if<0>(&this->m_value)); }
+
+  [[nodiscard]] inline auto operator*() &       -> T &       { return this->value(); }
+  [[nodiscard]] inline auto operator*() const & -> const T & { return this->value(); }
+  [[nodiscard]] inline auto operator*() &&      -> T &&      { return std::move(*this).value(); }
+  [[nodiscard]] inline auto operator->()       -> T *       { return &this->value(); }
+  [[nodiscard]] inline auto operator->() const -> const T * { return &this->value(); }
+
+  [[nodiscard]] inline auto error() &       -> E &       { return *std::get_if<1>(&this->m_value); }
+  [[nodiscard]] inline auto error() const & -> const E & { return *std::get_if<1>(&this->m_value); }
+  [[nodiscard]] inline auto error() &&      -> E &&      { return std::move(*std::get_if<1>(&this->m_value)); }
+
+  template<class U>
+  [[nodiscard]] auto value_or(U && other) const & -> T
+  {
+    return this->has_value() ? this->value() : static_cast<T>(std::forward<U>(other));
+  }
+  template<class U>
+  [[nodiscard]] auto value_or(U && other) && -> T
+  {
+    return this->has_value() ? std::move(*this).value() : static_cast<T>(std::forward<U>(other));
+  }
+};
+#endif
@@ -1,9 +1,65 @@
+#include <array>
+#include <charconv>
+#include <limits>
 #include <string_view>
+#include <thread>
 
 #include "serializer.hpp"
 #include "linker_file.hpp"
 
-void linkerFile::fromJSON(const std::string & input, std::optional<data_t> & data)
+auto linkerFile::parseNumber(std::string_view text) -> std::optional<linker::number_t>
+{
+  using number_t = linker::number_t;
+
+  if(!text.empty() && text.front() == '+')
+    text.remove_prefix(1);
+
+  // Short numbers without exponent (what formatNumber writes): the digits and the power of ten
+  // are both exact in number_t, so a single division rounds correctly (Clinger's fast path)
+  constexpr int digits = std::numeric_limits<number_t>::digits10;
+  static constexpr auto powers = []
+  {
+    std::array<number_t, digits + 1> ret {};
+    ret[0] = 1;
+    for(std::size_t i = 1; i < ret.size(); i++) ret[i] = ret[i - 1] * 10;
+    return ret;
+  }();
+
+  const bool    negative = !text.empty() && text.front() == '-';
+  std::size_t   pos      = negative ? 1 : 0;
+  std::uint64_t mantissa = 0;
+  int           count    = 0;
+  int           scale    = 0;
+  bool          dot      = false;
+
+  for(; pos < text.size(); pos++)
+  {
+    const char sym = text[pos];
+
+    if(sym >= '0' && sym <= '9')
+    {
+      mantissa = mantissa * 10 + std::uint64_t(sym - '0');
+      count++;
+      if(dot) scale++;
+    }
+    else if(sym == '.' && !dot) dot = true;
+    else break;
+  }
+
+  if(count > 0 && count <= digits && (pos == text.size() || (text[pos] != 'e' && text[pos] != 'E')))
+  {
+    const number_t value = number_t(mantissa) / powers[std::size_t(scale)];
+    return negative ? -value : value;
+  }
+
+  number_t value {};
+  if(std::from_chars(text.data(), text.data() + text.size(), value).ec != std::errc())
+    return std::nullopt;
+
+  return value;
+}
+
+void linkerFile::fromJSON(std::string_view input, std::optional<data_t> & data)
 {
   data_t rdata;
 
@@ -11,9 +67,7 @@ void linkerFile::fromJSON(const std::string & input, std::optional<data_t> & dat
   std::size_t subBraces = 0;
   std::string symSubBraces;
   bool colon  = false;     /*   :   */
-  bool string = false;     /* "..." */
 //  bool array  = false;     /* [,,,] */
-  bool quotes = false;     /*   /    */
 
   std::string str;
   std::string name;
@@ -53,54 +107,41 @@ void linkerFile::fromJSON(const std::string & input, std::optional<data_t> & dat
     }
   };
 
-  for(auto sym : input)
+  for(std::size_t i = 0; i < input.size(); i++)
   {
-    if((sym == '\t' || sym == '\n' || sym == '\r' || sym == ' ') && !string) continue;
+    const char sym = input[i];
+
+    if(sym == '\t' || sym == '\n' || sym == '\r' || sym == ' ') continue;
 
     if(braces)
     {
-      if(sym == '\"' || string)
+      if(sym == '\"')
       {
-        if(!string)
-        {
-          string = true;
+        const std::size_t end = linkerString::end(input, i + 1);
+        if(end == std::string::npos) break;
 
-          if(!subBraces) str = "";
-          else           str += sym;
+        const std::string_view body(input.data() + i + 1, end - i - 1);
+        i = end;
 
+        // Nested strings keep their escapes for their own pass
+        if(subBraces)
+        {
+          str += '\"';
+          str += body;
+          str += '\"';
           continue;
         }
 
-        if(!quotes)
-        {
-          if(sym == '\\' && !subBraces)
-          {
-            quotes = true;
-            continue;
-          }
-          if(sym == '\"')
-          {
-            string = false;
-
-            if(!subBraces)
-            {
-              if(!colon && !isArray())
-              {
-                name = str;
-              }
-              else save(linker::from(str));
-
-              str = "";
-              continue;
-            }
-          }
-        }
-        else
+        str = "";
+        linkerString::unescape(body, str);
+
+        if(!colon && !isArray())
         {
-          quotes = false;
+          name = str;
         }
+        else save(linker::from(str));
 
-        str += sym;
+        str = "";
       }
       else if (((colon || isArray()) && (sym == '[' || sym == '{')) || subBraces)
       {
@@ -122,6 +163,16 @@ void linkerFile::fromJSON(const std::string & input, std::optional<data_t> & dat
 
         if(subBraces) continue;
 
+        if(symSubBraces[0] == '[')
+        {
+          if(auto packed = linkerFile::parsePacked(str))
+          {
+            save(linker::packed(std::move(*packed)));
+            str = "";
+            continue;
+          }
+        }
+
         std::optional<data_t> data;
 
         fromJSON(str, data);
@@ -150,18 +201,9 @@ void linkerFile::fromJSON(const std::string & input, std::optional<data_t> & dat
           {
             save(linker::from(linker::null_t()));
           }
-          else
-          {
-          try
+          else if(auto value = linkerFile::parseNumber(str))
           {
-            linker::number_t value = std::stold(str);
-            save(linker() << value);
-            // std::cout << "{" << value << "|" << name << "}" << std::endl;
-          }
-          catch(...)
-          {
-//           std::cout << name << "|" << str << "|" << std::endl;
-          }
+            save(linker() << *value);
           }
           str = "";
         }
@@ -192,73 +234,852 @@ void linkerFile::fromJSON(const std::string & input, std::optional<data_t> & dat
   retValues();
 }
 
+auto linkerFile::formatNumber(linker::number_t number) -> std::string
+{
+  std::string num = std::to_string(number);
+  int i;
+  for(i = (int)num.length() - 1; i > 0; i--)
+  {
+    if(num[i] != '0')
+    {
+      if(num[i] == '.') i--;
+
+      break;
+    }
+  }
+  num.resize(std::size_t(i + 1));
+  return num;
+}
+
+void linkerFile::roundNumbers(linker & lnk)
+{
+  switch(lnk.type())
+  {
+  case linker::Types::Number: {
+    const auto number  = lnk.cast<linker::number_t>();
+    const auto written = linkerFile::parseNumber(linkerFile::formatNumber(number));
+
+    if(written && *written != number)
+      lnk = linker() << *written;
+  } break;
+  case linker::Types::Array: {
+    if(auto * pArr = lnk.isPacked() ? nullptr : lnk.write<linker::array_t>())
+    {
+      for(auto & child : *pArr)
+        linkerFile::roundNumbers(child);
+    }
+  } break;
+  case linker::Types::Object: {
+    if(auto * pObj = lnk.write<linker::object_t>())
+    {
+      for(auto & [key, child] : *pObj)
+        linkerFile::roundNumbers(child);
+    }
+  } break;
+  default:
+    break;
+  }
+}
+
+auto linkerFile::node(data_t && data) -> linker
+{
+  linker ret;
+
+  if(auto * pArr = std::get_if<1>(&data))
+  {
+    ret.m_type = linker::Types::Array;
+    ret.store(std::move(*pArr));
+  }
+  else
+  {
+    ret.m_type = linker::Types::Object;
+    ret.store(std::move(std::get<0>(data)));
+  }
+  return ret;
+}
+
 auto linkerFile::isJSONArray() const -> bool
 {
-  if(this->data) return (std::get_if<1>(&*this->data) != nullptr);
-  return false;
+  return this->root.type() == linker::Types::Array;
 }
 auto linkerFile::isJSONObject() const -> bool
 {
-  if(this->data) return (std::get_if<0>(&*this->data) != nullptr);
-  return false;
+  return this->root.type() == linker::Types::Object;
 }
 auto linkerFile::isEmpty() const -> bool
 {
-  return !this->data;
+  return !this->isJSONObject() && !this->isJSONArray();
 }
 
-auto linkerFile::toJSON(bool is_short) -> std::string
+auto linkerFile::operator==(const linkerFile & other) const -> bool
 {
-  switch(this->data->index())
+  return this->root == other.root;
+}
+
+auto linkerFile::toJSON(bool is_short) const -> std::string
+{
+  Writer out;
+  this->serialize(is_short, out);
+
+  return std::move(out.text);
+}
+
+void linkerFile::write(const Sink & sink, bool is_short) const
+{
+  Writer out { {}, &sink };
+  out.text.reserve(Writer::chunk + Writer::chunk / 4);
+
+  this->serialize(is_short, out);
+  out.flush(true);
+}
+
+void linkerFile::toJSON(const linker & lnk, bool is_short, int tabs, Writer & out) const
+{
+  std::string & output = out.text;
+
+  switch (lnk.type())
   {
-  case 0: return this->toJSON<linker::object_t>(std::get<0>(*this->data), is_short, 0); break;
-  case 1: return this->toJSON<linker::array_t>(std::get<1>(*this->data), is_short, 0); break;
+  case linker::Types::Number: {
+    output += linkerFile::formatNumber(lnk.cast<linker::number_t>());
+  } break;
+  case linker::Types::String: {
+    output += '"';
+    linkerString::escape(lnk.ref<linker::string_t>(), output);
+    output += '"';
+  } break;
+  case linker::Types::Array: {
+    if(const auto * pPacked = lnk.peek<linker::packed_t>())
+      linkerFile::toJSON(*pPacked, is_short, tabs, out);
+    else
+      this->toJSON(lnk.ref<linker::array_t>(), is_short, tabs, out);
+  } break;
+  case linker::Types::Object: {
+    this->toJSON(lnk.ref<linker::object_t>(), is_short, tabs, out);
+  } break;
+  case linker::Types::Bool: {
+    output += lnk.cast<linker::bool_t>() ? "true" : "false";
+  } break;
+  default: {
+    output += "null";
+  } break;
   }
-  return "";
 }
 
-auto linkerFile::fromJSON(const std::string & input) -> linkerFile &
+auto linkerFile::fromJSON(std::string_view input) -> linkerFile &
 {
-  this->data = std::nullopt;
-  this->fromJSON(input, this->data);
+  std::optional<data_t> data;
+
+  if(const auto threads = linkerFile::workers(input.size()); threads > 1)
+    data = linkerFile::parseParallel(input, threads);
+
+  if(!data)
+    this->fromJSON(input, data);
+
+  this->root = data ? linkerFile::node(std::move(*data)) : linker();
 
   return *this;
 }
 
 auto linkerFile::getJSONObject() const -> linker::object_t
 {
-  if(!this->isEmpty())
+  return this->root.cast<linker::object_t>();
+}
+auto linkerFile::getJSONArray() const -> linker::array_t
+{
+  return this->root.cast<linker::array_t>();
+}
+auto linkerFile::members() const -> const linker::object_t *
+{
+  return this->root.peek<linker::object_t>();
+}
+
+void linkerFile::setJSONObject(const linker::object_t & map)
+{
+  this->root = linkerFile::node(map);
+}
+void linkerFile::setJSONArray(const linker::array_t & arr)
+{
+  this->root = linkerFile::node(arr);
+}
+
+
+auto linkerFile::find(const linkerPath & path) const -> const linker *
+{
+  if(this->isEmpty() || path.empty())
+    return nullptr;
+
+  const linker * node = &this->root;
+
+  for(std::size_t i = 0; node != nullptr && i < path.size(); i++)
   {
-    return std::get<0>(*this->data);
+    node = (node->type() == linker::Types::Array) ? node->find(linkerPath::index(path[i]))
+                                                  : node->find(path[i]);
   }
-  return {};
+  return node;
 }
-auto linkerFile::getJSONArray() const -> linker::array_t
+
+auto linkerFile::find(const linkerPath & path) -> const linker *
 {
-  if(!this->isEmpty())
+  if(this->isEmpty() || path.empty())
+    return nullptr;
+
+  // Unpacking writes, so every node on the way is detached from any snapshot
+  linker * node = &this->root;
+
+  for(std::size_t i = 0; node != nullptr && i < path.size(); i++)
   {
-    return std::get<1>(*this->data);
+    if(node->type() == linker::Types::Array)
+    {
+      node->unpack();
+      node = node->locate(linkerPath::index(path[i]));
+    }
+    else node = node->locate(path[i]);
   }
-  return {};
+  return node;
 }
 
-void linkerFile::setJSONObject(const linker::object_t & map)
+auto linkerFile::at(const linkerPath & path) const -> linker
 {
-  this->data = map;
+  if(this->isEmpty())
+    return {};
+
+  const linker * node = &this->root;
+
+  for(std::size_t i = 0; node != nullptr && i < path.size(); i++)
+  {
+    const auto index = linkerPath::index(path[i]);
+
+    // Packed elements have no node, the last component is copied out by value
+    if(const auto * pPacked = node->peek<linker::packed_t>(); pPacked && i + 1 == path.size())
+    {
+      return std::visit([index](const auto & values)
+      {
+        return index < values.size() ? linker::from(values[index]) : linker();
+      }, *pPacked);
+    }
+
+    node = (node->type() == linker::Types::Array) ? node->find(index) : node->find(path[i]);
+  }
+  return node ? *node : linker();
 }
-void linkerFile::setJSONArray(const linker::array_t & arr)
+
+auto linkerFile::assign(const linkerPath & path, linker value) -> std::optional<linker::Error>
+{
+  if(path.empty())
+  {
+    if(value.type() != linker::Types::Object && value.type() != linker::Types::Array)
+      return linker::Error { linker::Error::Code::TypeMismatch };
+
+    this->root = std::move(value);
+    this->root.unpack();
+    return std::nullopt;
+  }
+
+  // Checked before anything is written: arrays are neither turned into objects nor grown by
+  // more than one element
+  const auto elements = [](const linker & node) -> std::size_t
+  {
+    if(const auto * pPacked = node.peek<linker::packed_t>())
+      return std::visit([](const auto & values) { return values.size(); }, *pPacked);
+
+    const auto * pArr = node.peek<linker::array_t>();
+    return pArr ? pArr->size() : 0;
+  };
+
+  linkerPath     parent;
+  const linker * pNode = this->isEmpty() ? nullptr : &this->root;
+
+  for(std::size_t i = 0; pNode != nullptr && i < path.size(); i++)
+  {
+    if(pNode->type() == linker::Types::Array)
+    {
+      const auto index = linkerPath::index(path[i]);
+      if(index == std::string::npos)
+        return linker::Error { linker::Error::Code::TypeMismatch, parent.toPointer() };
+      if(index > elements(*pNode))
+        return linker::Error { linker::Error::Code::MissingKey, parent.toPointer() };
+
+      pNode = pNode->find(index);
+    }
+    else pNode = pNode->find(path[i]);
+
+    parent = parent.child(path[i]);
+  }
+
+  if(this->isEmpty())
+    this->root = linkerFile::node(linker::object_t());
+
+  linker * node = &this->root;
+
+  for(std::size_t i = 0; i < path.size(); i++)
+  {
+    node = (node->type() == linker::Types::Array) ? &node->child(linkerPath::index(path[i]))
+                                                  : &node->child(path[i]);
+  }
+  *node = std::move(value);
+  return std::nullopt;
+}
+
+auto linkerFile::merge(const linkerPath & path, linker value) -> std::optional<linker::Error>
+{
+  const linker * pOld = this->find(path);
+
+  if(pOld == nullptr || pOld->type() != linker::Types::Object || value.type() != linker::Types::Object)
+    return this->assign(path, std::move(value));
+
+  for(auto & [key, field] : std::move(value).value<linker::object_t>())
+  {
+    const linker * pField = pOld->find(key);
+
+    if(pField == nullptr || *pField != field)
+    {
+      if(auto error = this->assign(path.child(key), std::move(field)))
+        return error;
+    }
+  }
+  return std::nullopt;
+}
+
+//--------------------------------------------------------------------------------------------------
+static auto skipSpaces(std::string_view input, std::size_t pos) -> std::size_t
+{
+  while(pos < input.size()
+     && (input[pos] == ' ' || input[pos] == '\t' || input[pos] == '\n' || input[pos] == '\r'))
+  {
+    pos++;
+  }
+  return pos;
+}
+
+// pos is at the opening quote, returns the position after the closing one
+static auto skipString(std::string_view input, std::size_t pos) -> std::size_t
+{
+  pos = linkerString::end(input, pos + 1);
+  return pos == std::string_view::npos ? pos : pos + 1;
+}
+
+static auto skipValue(std::string_view input, std::size_t pos) -> std::size_t
+{
+  if(pos >= input.size())
+    return std::string_view::npos;
+
+  if(input[pos] == '\"')
+    return skipString(input, pos);
+
+  if(input[pos] == '{' || input[pos] == '[')
+  {
+    std::size_t depth = 0;
+    while(pos < input.size())
+    {
+      const char sym = input[pos];
+      if(sym == '\"')
+      {
+        pos = skipString(input, pos);
+        if(pos == std::string_view::npos) break;
+        continue;
+      }
+
+      if(sym == '{' || sym == '[') depth++;
+      else if((sym == '}' || sym == ']') && --depth == 0) return pos + 1;
+
+      pos++;
+    }
+    return std::string_view::npos;
+  }
+
+  while(pos < input.size() && input[pos] != ',' && input[pos] != '}' && input[pos] != ']'
+     && input[pos] != ' ' && input[pos] != '\t' && input[pos] != '\n' && input[pos] != '\r')
+  {
+    pos++;
+  }
+  return pos;
+}
+
+static auto parseError(std::size_t offset) -> linker::Error
+{
+  return linker::Error { linker::Error::Code::Parse, {}, offset };
+}
+
+// Strict check of the value at pos, which is left after it. An error holds the offset of the
+// first character that does not fit and the pointer to the value it was found in
+static auto validate(std::string_view input, std::size_t & pos) -> std::optional<linker::Error>
 {
-  this->data = arr;
+  constexpr auto npos = std::string_view::npos;
+
+  pos = skipSpaces(input, pos);
+  if(pos >= input.size())
+    return parseError(pos);
+
+  const char sym = input[pos];
+  if(sym == '{' || sym == '[')
+  {
+    const char  close = (sym == '{') ? '}' : ']';
+    std::size_t index = 0;
+
+    pos = skipSpaces(input, pos + 1);
+    if(pos < input.size() && input[pos] == close)
+    {
+      pos++;
+      return std::nullopt;
+    }
+
+    while(true)
+    {
+      std::string_view key;
+      if(sym == '{')
+      {
+        if(pos >= input.size() || input[pos] != '\"') return parseError(pos);
+
+        const std::size_t end = linkerString::end(input, pos + 1);
+        if(end == npos) return parseError(pos);
+
+        key = input.substr(pos + 1, end - pos - 1);
+        pos = skipSpaces(input, end + 1);
+
+        if(pos >= input.size() || input[pos] != ':') return parseError(pos);
+        pos++;
+      }
+
+      if(auto error = validate(input, pos))
+      {
+        error->path.insert(0, (sym == '{') ? linkerPath::key(linkerString::unescape(key)).toPointer()
+                                           : "/" + std::to_string(index));
+        return error;
+      }
+
+      pos = skipSpaces(input, pos);
+      if(pos < input.size() && input[pos] == ',')
+      {
+        pos = skipSpaces(input, pos + 1);
+        index++;
+      }
+      else if(pos < input.size() && input[pos] == close)
+      {
+        pos++;
+        return std::nullopt;
+      }
+      else return parseError(pos);
+    }
+  }
+
+  if(sym == '\"')
+  {
+    const std::size_t end = linkerString::end(input, pos + 1);
+    if(end == npos) return parseError(pos);
+
+    pos = end + 1;
+    return std::nullopt;
+  }
+
+  for(const std::string_view literal : { "true", "false", "null" })
+  {
+    if(input.substr(pos, literal.size()) == literal)
+    {
+      pos += literal.size();
+      return std::nullopt;
+    }
+  }
+
+  // Numbers as written by formatNumber(), inf and nan included
+  linker::number_t value {};
+  const auto result = std::from_chars(input.data() + pos, input.data() + input.size(), value);
+  if(result.ec != std::errc())
+    return parseError(pos);
+
+  pos = std::size_t(result.ptr - input.data());
+  return std::nullopt;
+}
+
+auto linkerFile::parse(const std::string & input) -> linker::expected_t<linkerFile>
+{
+  std::size_t pos = skipSpaces(input, 0);
+
+  if(pos >= input.size() || (input[pos] != '{' && input[pos] != '['))
+    return linkerUnexpected<linker::Error>(parseError(pos));
+
+  if(auto error = validate(input, pos))
+    return linkerUnexpected<linker::Error>(std::move(*error));
+
+  if(pos = skipSpaces(input, pos); pos != input.size())
+    return linkerUnexpected<linker::Error>(parseError(pos));
+
+  linkerFile file;
+  file.fromJSON(input);
+
+  return file;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Runs job(0 .. count-1) on up to threads threads, the caller's thread included
+static void parallelFor(std::size_t count, std::size_t threads, const std::function<void(std::size_t)> & job)
+{
+  std::atomic<std::size_t> next = 0;
+
+  auto work = [&]
+  {
+    for(std::size_t i = next++; i < count; i = next++)
+      job(i);
+  };
+
+  std::vector<std::jthread> pool;
+  for(std::size_t i = 1; i < std::min(threads, count); i++)
+    pool.emplace_back(work);
+
+  work();
+}
+
+void linkerFile::setParallel(std::size_t threshold, std::size_t threads)
+{
+  linkerFile::parallelThreshold = threshold;
+  linkerFile::parallelThreads   = threads;
+}
+
+auto linkerFile::workers(std::size_t size) -> std::size_t
+{
+  const std::size_t threshold = linkerFile::parallelThreshold;
+  if(threshold == 0 || size < threshold)
+    return 1;
+
+  const std::size_t threads = linkerFile::parallelThreads;
+  return threads ? threads : std::max(1U, std::thread::hardware_concurrency());
+}
+
+auto linkerFile::textSize(const linker & lnk, std::size_t limit) -> std::size_t
+{
+  switch(lnk.type())
+  {
+  case linker::Types::String: return lnk.ref<linker::string_t>().size() + 2;
+  case linker::Types::Number: return 8;
+  case linker::Types::Array: {
+    if(const auto * pPacked = lnk.peek<linker::packed_t>())
+      return std::visit([](const auto & values) { return values.size() * 8 + 2; }, *pPacked);
+
+    std::size_t size = 2;
+    for(const auto & item : lnk.ref<linker::array_t>())
+    {
+      if((size += textSize(item, limit - std::min(size, limit)) + 2) >= limit) break;
+    }
+    return size;
+  }
+  case linker::Types::Object: {
+    std::size_t size = 2;
+    for(const auto & [key, item] : lnk.ref<linker::object_t>())
+    {
+      if((size += key.str().size() + textSize(item, limit - std::min(size, limit)) + 6) >= limit) break;
+    }
+    return size;
+  }
+  default: return 5;
+  }
+}
+
+void linkerFile::serialize(bool is_short, Writer & out) const
+{
+  const std::size_t threshold = linkerFile::parallelThreshold;
+  const std::size_t threads   = threshold ? linkerFile::workers(textSize(this->root, threshold)) : 1;
+
+  if(threads > 1)                this->serializeParallel(is_short, threads, out);
+  else if(this->isJSONObject())  this->toJSON(this->root.ref<linker::object_t>(), is_short, 0, out);
+  else if(this->isJSONArray())   this->toJSON(this->root.ref<linker::array_t>(), is_short, 0, out);
+}
+
+void linkerFile::serializeParallel(bool is_short, std::size_t threads, Writer & out) const
+{
+  auto run = [&](const auto & data)
+  {
+    const std::size_t size   = data.size();
+    const std::size_t pieces = std::min(size, threads * 4);
+
+    // Piece p holds elements [p * size / pieces, (p + 1) * size / pieces)
+    std::vector<decltype(data.begin())> cuts;
+    cuts.reserve(pieces + 1);
+    for(std::size_t p = 0, index = 0; p <= pieces; p++)
+    {
+      const std::size_t next = pieces ? p * size / pieces : 0;
+      cuts.push_back(cuts.empty() ? data.begin() : std::next(cuts.back(), std::ptrdiff_t(next - index)));
+      index = next;
+    }
+
+    out.text += is_linker_arr_v<std::decay_t<decltype(data)>> ? '[' : '{';
+    if(size) linkerFile::newline(is_short, 1, out.text);
+
+    // One wave per pool size, at most a wave of text is held before the sink takes it
+    for(std::size_t wave = 0; wave < pieces; wave += threads)
+    {
+      const std::size_t count = std::min(threads, pieces - wave);
+      std::vector<Writer> parts(count);
+
+      parallelFor(count, threads, [&](std::size_t k)
+      {
+        const std::size_t p = wave + k;
+        std::size_t index   = p * size / pieces;
+
+        for(auto it = cuts[p]; it != cuts[p + 1]; it++)
+          this->member(*it, ++index == size, is_short, 1, parts[k]);
+      });
+
+      for(auto & part : parts)
+      {
+        out.text += part.text;
+        out.flush();
+      }
+    }
+
+    out.text += is_linker_arr_v<std::decay_t<decltype(data)>> ? ']' : '}';
+  };
+
+  if(this->isJSONObject())     run(this->root.ref<linker::object_t>());
+  else if(this->isJSONArray()) run(this->root.ref<linker::array_t>());
+}
+
+auto linkerFile::parseParallel(std::string_view input, std::size_t threads) -> std::optional<data_t>
+{
+  constexpr auto npos = std::string_view::npos;
+
+  std::size_t pos = skipSpaces(input, 0);
+  if(pos >= input.size() || (input[pos] != '{' && input[pos] != '['))
+    return std::nullopt;
+
+  const bool isArray = input[pos] == '[';
+  const char close   = isArray ? ']' : '}';
+
+  // Boundary scan, only strings and nesting are tracked. A few pieces per
+  // thread keep the load balanced when element sizes vary
+  const std::size_t target = std::max<std::size_t>(input.size() / (threads * 4), 1);
+
+  std::vector<std::string_view> pieces;
+  std::size_t                   begin = npos;
+
+  for(pos = skipSpaces(input, pos + 1); pos < input.size() && input[pos] != close;)
+  {
+    const std::size_t start = pos;
+
+    if(!isArray)
+    {
+      if(input[pos] != '\"') return std::nullopt;
+
+      pos = skipSpaces(input, skipString(input, pos));
+      if(pos >= input.size() || input[pos] != ':') return std::nullopt;
+
+      pos = skipSpaces(input, pos + 1);
+    }
+
+    pos = skipValue(input, pos);
+    if(pos == npos) return std::nullopt;
+
+    if(begin == npos) begin = start;
+    if(pos - begin >= target)
+    {
+      pieces.push_back(input.substr(begin, pos - begin));
+      begin = npos;
+    }
+
+    pos = skipSpaces(input, pos);
+    if(pos < input.size() && input[pos] == ',')
+      pos = skipSpaces(input, pos + 1);
+    else if(pos >= input.size() || input[pos] != close)
+      return std::nullopt;
+  }
+  if(pos >= input.size())
+    return std::nullopt;
+
+  if(begin != npos)
+    pieces.push_back(input.substr(begin, pos - begin));
+
+  std::vector<std::optional<data_t>> parsed(pieces.size());
+
+  parallelFor(pieces.size(), threads, [&](std::size_t i)
+  {
+    std::string text;
+    text.reserve(pieces[i].size() + 2);
+    text += isArray ? '[' : '{';
+    text += pieces[i];
+    text += close;
+
+    linkerFile().fromJSON(text, parsed[i]);
+  });
+
+  // Stitched in document order, for objects a later duplicate key wins as it does sequentially
+  if(isArray)
+  {
+    linker::array_t arr;
+    for(auto & piece : parsed)
+    {
+      if(!piece || piece->index() != 1) return std::nullopt;
+
+      auto & items = std::get<1>(*piece);
+      arr.insert(arr.end(), std::make_move_iterator(items.begin()), std::make_move_iterator(items.end()));
+    }
+    return data_t(std::move(arr));
+  }
+
+  linker::object_t obj;
+  for(auto it = parsed.rbegin(); it != parsed.rend(); it++)
+  {
+    if(!*it || (*it)->index() != 0) return std::nullopt;
+    obj.merge(std::get<0>(**it));
+  }
+  return data_t(std::move(obj));
 }
 
+//--------------------------------------------------------------------------------------------------
+void linkerFile::toJSON(const linker::packed_t & packed, bool is_short, int tabs, Writer & out)
+{
+  std::visit([is_short, tabs, &out](const auto & values)
+  {
+    std::string & output = out.text;
+
+    if(values.empty())
+    {
+      output += "[]";
+      return;
+    }
+
+    std::string indent;
+    if(!is_short)
+      indent = "\n" + std::string(std::size_t(tabs + 1), '\t');
+
+    output.reserve(output.size() + std::min(values.size(), Writer::chunk) * (indent.size() + 12) + 2);
+    output += '[';
+
+    std::array<char, 64> buf;
+    for(std::size_t i = 0; i < values.size(); i++)
+    {
+      output += (i ? "," : "");
+      output += indent;
+
+      const auto result = std::to_chars(buf.data(), buf.data() + buf.size(), values[i]);
+      output.append(buf.data(), result.ptr);
+
+      if((i & 1023) == 1023) out.flush();
+    }
+
+    if(!is_short)
+    {
+      output += '\n';
+      output.append(std::size_t(std::max(tabs, 0)), '\t');
+    }
+    output += ']';
+  }, packed);
+}
+
+auto linkerFile::parsePacked(std::string_view input) -> std::optional<linker::packed_t>
+{
+  const std::size_t first = input.find_first_not_of(" \t\n\r");
+  const std::size_t last  = input.find_last_not_of(" \t\n\r");
+
+  if(first == std::string_view::npos || input[first] != '[' || input[last] != ']')
+    return std::nullopt;
+
+  const std::string_view body = input.substr(first + 1, last - first - 1);
+
+  // Anything but digits, signs, separators and exponents means a mixed array
+  bool isFloat = false;
+  bool isEmpty = true;
+  for(const char sym : body)
+  {
+    if(sym == '.' || sym == 'e' || sym == 'E') isFloat = true;
+    else if((sym < '0' || sym > '9') && sym != '-' && sym != '+' && sym != ','
+         && sym != ' ' && sym != '\t' && sym != '\n' && sym != '\r')
+      return std::nullopt;
+    else if(sym >= '0' && sym <= '9') isEmpty = false;
+  }
+  if(isEmpty)
+    return std::nullopt;
+
+  auto parse = [body]<typename T>(std::vector<T> && values) -> std::optional<linker::packed_t>
+  {
+    const char * it  = body.data();
+    const char * end = body.data() + body.size();
+
+    values.reserve(std::size_t(std::count(it, end, ',')) + 1);
+
+    while(true)
+    {
+      while(it != end && (*it == ' ' || *it == '\t' || *it == '\n' || *it == '\r')) it++;
+
+      T value;
+      const auto result = std::from_chars(it, end, value);
+      if(result.ec != std::errc()) return std::nullopt;
+      values.push_back(value);
+
+      it = result.ptr;
+      while(it != end && (*it == ' ' || *it == '\t' || *it == '\n' || *it == '\r')) it++;
+
+      if(it == end)  break;
+      if(*it != ',') return std::nullopt;
+      it++;
+    }
+    return linker::packed_t(std::move(values));
+  };
+
+  // Decimals keep number_t precision, as they have in an unpacked array
+  return isFloat ? parse(std::vector<linker::number_t>()) : parse(std::vector<int64_t>());
+}
+
+//--------------------------------------------------------------------------------------------------
+auto linker::operator==(const linker & other) const -> bool
+{
+  if(this->m_type != other.m_type)
+    return false;
+
+  switch(this->m_type)
+  {
+  case Types::Bool:
+    return this->cast<bool_t>() == other.cast<bool_t>();
+  case Types::Number: {
+    const auto lhs = this->cast<number_t>();
+    const auto rhs = other.cast<number_t>();
+
+    // Equal once written out counts as unchanged, the text keeps 6 decimals
+    return lhs == rhs || linkerFile::formatNumber(lhs) == linkerFile::formatNumber(rhs);
+  }
+  case Types::String:
+    return this->ref<string_t>() == other.ref<string_t>();
+  case Types::Object: {
+    // Subtrees still shared with a snapshot are equal without being walked
+    const auto * pLhs = this->peek<object_t>();
+    const auto * pRhs = other.peek<object_t>();
+
+    return pLhs == pRhs || this->ref<object_t>() == other.ref<object_t>();
+  }
+  case Types::Array: {
+    if(this->peek<array_t>() != nullptr && this->peek<array_t>() == other.peek<array_t>())
+      return true;
+
+    const auto * pLhs = this->peek<packed_t>();
+    const auto * pRhs = other.peek<packed_t>();
+
+    if(pLhs != nullptr && pLhs == pRhs)
+      return true;
+
+    if(pLhs && pRhs)
+    {
+      return std::visit([](const auto & lhs, const auto & rhs)
+      {
+        return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(),
+                          [](auto a, auto b) { return (long double)a == (long double)b; });
+      }, *pLhs, *pRhs);
+    }
+
+    array_t lhs;
+    array_t rhs;
+    return this->items(lhs) == other.items(rhs);
+  }
+  default:
+    return true;
+  }
+}
 
 auto linker::operator>>(Serializer & object) const -> Serializer &
 {
   if (Types::Object != this->m_type)
     return object;
 
+  const auto & map = this->ref<object_t>();
+
   for (auto arrpProps = object.getPropertysArray(); auto & prop : arrpProps)
-    prop->copy_from(this->value<object_t>());
+    prop->copy_from(map);
 
   return object;
 }
@@ -271,7 +1092,7 @@ auto linker::operator<<(const Serializer & object) -> linker &
     prop->copy_to(map);
 
   this->m_type = Types::Object;
-  this->m_value = map;
+  this->store(std::move(map));
 
   return *this;
 };
@@ -1,129 +1,175 @@
 #pragma once
 
+#include <atomic>
+#include <functional>
+#include <string_view>
+
 #include "linker.hpp"
+#include "linker_path.hpp"
+#include "linker_string.hpp"
 
 class linkerFile
 {
   using data_t = std::variant<linker::object_t, linker::array_t>;
 
-  std::optional<data_t> data = std::nullopt;
+public:
+  // Receives the text in order, a chunk at a time
+  using Sink = std::function<void(std::string_view)>;
 
-  template<typename T>
-  auto toJSON(const T & data, const bool is_short, int tabs) -> std::string
+private:
+
+  // Object or array once loaded, copying a linkerFile shares the whole tree
+  linker root;
+
+  // Text being produced, handed to the sink whenever a chunk is full
+  struct Writer
   {
-    auto print_tabs = [is_short](const int count) -> std::string
+    static constexpr std::size_t chunk = 64 * 1024;
+
+    std::string  text;
+    const Sink * pSink = nullptr;
+
+    inline void flush(bool force = false)
     {
-      if(!is_short)
+      if(this->pSink && !this->text.empty() && (force || this->text.size() >= chunk))
       {
-        std::string ret;
-        for(int i = 0; i < count; i++)
-          ret += "\t";
-        return ret;
+        (*this->pSink)(this->text);
+        this->text.clear();
       }
-      return "";
-    };
-    auto print_enter = [is_short]() -> std::string
-    {
-      return is_short ? "" : "\n";
-    };
-    [[maybe_unused]] auto print_space = [is_short]() -> std::string
-    {
-      return is_short ? "" : " ";
-    };
+    }
+  };
 
-    std::function<std::string(const linker &)> convert =
-        [&](const linker & lnk)
+  static inline void newline(const bool is_short, const int tabs, std::string & output)
+  {
+    if(!is_short)
     {
-      std::string output;
+      output += '\n';
+      output.append(std::size_t(std::max(tabs, 0)), '\t');
+    }
+  }
 
-      switch (lnk.type())
-      {
-      case linker::Types::Number: {
-        std::string num = std::to_string(lnk.cast<linker::number_t>());
-        int i;
-        for(i = (int)num.length() - 1; i > 0; i--)
-        {
-          if(num[i] != '0')
-          {
-            if(num[i] == '.') i--;
-
-            break;
-          }
-        }
-        output += num.substr(0, i + 1);
-      } break;
-      case linker::Types::String: {
-        auto str = lnk.cast<linker::string_t>();
-
-        output += "\"";
-        for(const auto & sym : str)
-        {
-            if(sym == '\\' || sym == '\"')
-                output += "\\";
-            output += sym;
-        }
-        output += "\"";
-      } break;
-      case linker::Types::Array: {
-        output += this->toJSON(lnk.cast<linker::array_t>(), is_short, tabs);
-      } break;
-      case linker::Types::Object: {
-        output += this->toJSON(lnk.cast<linker::object_t>(), is_short, tabs);
-      } break;
-      case linker::Types::Bool: {
-        output += lnk.cast<linker::bool_t>() ? "true" : "false";
-      } break;
-      default: {
-        output += "null";
-      } break;
-      }
-      return output;
-    };
+  // One element of an array or object and what follows it
+  template<typename Item>
+  void member(const Item & obj, const bool last, const bool is_short, const int tabs, Writer & out) const
+  {
+    if constexpr (is_linker_v<Item>)
+    {
+      this->toJSON(obj, is_short, tabs, out);
+    }
+    else
+    {
+      out.text += '"';
+      linkerString::escape(obj.first.str(), out.text);
+      out.text += is_short ? "\":" : "\" : ";
+      this->toJSON(obj.second, is_short, tabs, out);
+    }
 
-    std::string symSubBraces;
-    std::size_t counter = 1;
-    std::size_t size    = data.size();
+    if(last) linkerFile::newline(is_short, tabs - 1, out.text);
+    else
+    {
+      out.text += ',';
+      linkerFile::newline(is_short, tabs, out.text);
+    }
+  }
 
-    if constexpr (is_linker_arr_v<T>) symSubBraces = "[]";
-    else                              symSubBraces = "{}";
+  template<typename T>
+  void toJSON(const T & data, const bool is_short, int tabs, Writer & out) const
+  {
+    std::size_t left = data.size();
 
-    std::string output = symSubBraces[0] + (size ? print_enter() + print_tabs(++tabs) : "");
+    out.text += is_linker_arr_v<T> ? '[' : '{';
+    if(left) linkerFile::newline(is_short, ++tabs, out.text);
 
     for(const auto & obj : data)
     {
-      if constexpr (is_linker_obj_v<T>)
-      {
-        output += "\"" + obj.first + "\"" + print_space() + ":"
-               + print_space() + convert(obj.second);
-      }
-      else if constexpr (is_linker_arr_v<T>)
-      {
-        output += convert(obj);
-      }
-      output += (counter++ < size ? "," + print_enter() + print_tabs(tabs)
-                                  : print_enter());
+      this->member(obj, --left == 0, is_short, tabs, out);
+      out.flush();
     }
-    output += (size ? print_tabs(--tabs) : "") + symSubBraces[1];
-
-    if(tabs <= 0) this->data = data;
 
-    return output;
+    out.text += is_linker_arr_v<T> ? ']' : '}';
   }
 
-  void fromJSON(const std::string & input, std::optional<data_t> & data);
+  void toJSON(const linker & lnk, bool is_short, int tabs, Writer & out) const;
+  static void toJSON(const linker::packed_t & packed, bool is_short, int tabs, Writer & out);
+
+  // Whole document, top-level members are written on several threads when it is large
+  void serialize(bool is_short, Writer & out) const;
+  void serializeParallel(bool is_short, std::size_t threads, Writer & out) const;
+
+  void fromJSON(std::string_view input, std::optional<data_t> & data);
+
+  static auto node(data_t && data) -> linker;
+
+  inline static std::atomic<std::size_t> parallelThreshold = std::size_t(8) << 20;
+  inline static std::atomic<std::size_t> parallelThreads   = 0;
+
+  // Worker count for a document of size bytes, 1 below the threshold
+  [[nodiscard]] static auto workers(std::size_t size) -> std::size_t;
+  // Splits the top-level container at element boundaries and parses the pieces concurrently
+  [[nodiscard]] static auto parseParallel(std::string_view input, std::size_t threads)
+    -> std::optional<data_t>;
 
 public:
+  // Documents of at least threshold bytes are parsed and written on up to threads threads
+  // (hardware concurrency when 0), a threshold of 0 keeps everything on the caller's thread
+  static void setParallel(std::size_t threshold, std::size_t threads = 0);
+
+  // Rough text size of a subtree, counting stops once limit is reached
+  [[nodiscard]] static auto textSize(const linker & lnk, std::size_t limit) -> std::size_t;
+
+  // Text a scalar number is written as
+  [[nodiscard]] static auto formatNumber(linker::number_t number) -> std::string;
+  // Rounds every number in lnk to what formatNumber() writes for it, a document then holds what
+  // reading its file back gives. Packed arrays are written exactly and left alone
+  static void roundNumbers(linker & lnk);
+  // Leading number of text, nullopt when there is none (what std::stold accepted, without throwing)
+  [[nodiscard]] static auto parseNumber(std::string_view text) -> std::optional<linker::number_t>;
+
   [[nodiscard]] auto isJSONArray() const -> bool;
   [[nodiscard]] auto isJSONObject() const -> bool;
   [[nodiscard]] auto isEmpty() const -> bool;
 
-  auto toJSON(bool is_short = false) -> std::string;
+  // Documents sharing nodes (a copy and its original) compare without walking them
+  [[nodiscard]] auto operator==(const linkerFile & other) const -> bool;
 
-  auto fromJSON(const std::string & input) -> linkerFile &;
+  auto toJSON(bool is_short = false) const -> std::string;
+  // Same text as toJSON(), streamed so the whole document is never held at once
+  void write(const Sink & sink, bool is_short = false) const;
+
+  // Takes any text, a mapped file is parsed in place
+  auto fromJSON(std::string_view input) -> linkerFile &;
+  // Strict counterpart of fromJSON(), the first syntax error is reported with its offset
+  // instead of being skipped over
+  [[nodiscard]] static auto parse(const std::string & input) -> linker::expected_t<linkerFile>;
 
   [[nodiscard]] auto getJSONObject() const -> linker::object_t;
   [[nodiscard]] auto getJSONArray() const -> linker::array_t;
+  // Top-level members in place, nullptr unless the document is an object
+  [[nodiscard]] auto members() const -> const linker::object_t *;
 
   void setJSONObject(const linker::object_t & map);
   void setJSONArray(const linker::array_t & arr);
+
+  [[nodiscard]] auto find(const linkerPath & path) const -> const linker *;
+  // Same lookup, but packed arrays on the path are unpacked so their elements can be reached
+  [[nodiscard]] auto find(const linkerPath & path) -> const linker *;
+  // Copy of the value at path, elements of packed arrays included (shares subtrees, O(depth))
+  [[nodiscard]] auto at(const linkerPath & path) const -> linker;
+  // Checked read of the value at path, error paths are given from the document root
+  template<class T>
+  [[nodiscard]] auto get(const linkerPath & path) const -> linker::expected_t<T>
+  {
+    auto ret = this->at(path).template get<T>();
+    if(!ret) ret.error().path.insert(0, path.toPointer());
+
+    return ret;
+  }
+  // Replaces the value at path, creating objects on the way. An array takes only an index up to
+  // its size (which appends), anything else is an error and leaves the document unchanged
+  auto assign(const linkerPath & path, linker value) -> std::optional<linker::Error>;
+  // Like assign(), but an object value only replaces the members that differ
+  auto merge(const linkerPath & path, linker value) -> std::optional<linker::Error>;
+
+  // "[1, 2, 3]" straight into contiguous storage, nullopt unless every element is a number
+  [[nodiscard]] static auto parsePacked(std::string_view input) -> std::optional<linker::packed_t>;
 };
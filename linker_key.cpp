@@ -0,0 +1,93 @@
+#include <array>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_set>
+
+#include "linker_key.hpp"
+
+struct linkerKey::Shard
+{
+  struct Hash
+  {
+    using is_transparent = void;
+
+    auto operator()(std::string_view name) const -> std::size_t
+    {
+      return std::hash<std::string_view>()(name);
+    }
+    auto operator()(const Entry & entry) const -> std::size_t
+    {
+      return (*this)(entry.name);
+    }
+  };
+  struct Equal
+  {
+    using is_transparent = void;
+
+    auto operator()(std::string_view lhs, const Entry & rhs) const -> bool { return lhs == rhs.name; }
+    auto operator()(const Entry & lhs, std::string_view rhs) const -> bool { return lhs.name == rhs; }
+    auto operator()(const Entry & lhs, const Entry & rhs)    const -> bool { return lhs.name == rhs.name; }
+  };
+
+  std::shared_mutex                      mutex;
+  // Node storage, an entry stays in place until it is erased
+  std::unordered_set<Entry, Hash, Equal> table;
+
+  // The upper bits pick the shard, the table's buckets use the whole hash
+  static auto of(std::size_t hash) -> Shard &
+  {
+    static std::array<Shard, 64> shards;
+    return shards[(hash >> 20) % shards.size()];
+  }
+};
+
+auto linkerKey::intern(std::string_view name) -> const Entry *
+{
+  Shard & shard = Shard::of(Shard::Hash()(name));
+
+  {
+    std::shared_lock lock { shard.mutex };
+
+    // Counts only drop to 0 under the exclusive lock, together with the erase
+    if(auto it = shard.table.find(name); it != shard.table.end())
+    {
+      it->refs.fetch_add(1, std::memory_order_relaxed);
+      return &*it;
+    }
+  }
+
+  std::unique_lock lock { shard.mutex };
+
+  auto [it, inserted] = shard.table.emplace(name);
+  if(!inserted) it->refs.fetch_add(1, std::memory_order_relaxed);
+
+  return &*it;
+}
+
+void linkerKey::release(const Entry * pEntry)
+{
+  // Not the last key, no lock needed
+  std::size_t refs = pEntry->refs.load(std::memory_order_relaxed);
+  while(refs > 1)
+  {
+    if(pEntry->refs.compare_exchange_weak(refs, refs - 1, std::memory_order_release,
+                                          std::memory_order_relaxed))
+      return;
+  }
+
+  // Possibly the last: intern() may have taken another reference meanwhile
+  Shard & shard = Shard::of(Shard::Hash()(pEntry->name));
+  std::unique_lock lock { shard.mutex };
+
+  if(pEntry->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    shard.table.erase(shard.table.find(pEntry->name));
+}
+
+linkerKey::linkerKey()
+{
+  // Held for the whole run, default keys never reach the table's locks
+  static const linkerKey empty { std::string_view() };
+
+  this->pEntry = empty.pEntry;
+  this->pEntry->refs.fetch_add(1, std::memory_order_relaxed);
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <atomic>
+#include <compare>
+#include <concepts>
+#include <string>
+#include <string_view>
+#include <utility>
+
+// Object member name. The text is interned, stored once and shared by every live key with
+// that name, so a key costs one pointer and equal keys compare by address. Entries are
+// counted and freed with their last key, the table only holds the names in use. It is split
+// into shards with a lock each, threads parsing at once seldom wait on one another
+class linkerKey
+{
+  struct Entry
+  {
+    std::string                      name;
+    mutable std::atomic<std::size_t> refs = 1;
+
+    explicit Entry(std::string_view name) : name(name)
+    {
+      // Empty
+    }
+  };
+  struct Shard;
+
+  const Entry * pEntry;
+
+  // Entry of name, with a reference taken for the caller
+  [[nodiscard]] static auto intern(std::string_view name) -> const Entry *;
+  static void release(const Entry * pEntry);
+
+public:
+  linkerKey();
+  linkerKey(std::string_view name)     : pEntry(linkerKey::intern(name))
+  {
+    // Empty
+  }
+  linkerKey(const std::string & name)  : pEntry(linkerKey::intern(name))
+  {
+    // Empty
+  }
+  linkerKey(const char * name)         : pEntry(linkerKey::intern(name))
+  {
+    // Empty
+  }
+  ~linkerKey()
+  {
+    linkerKey::release(this->pEntry);
+  }
+
+  // A moved-from key keeps its name, moving costs what copying does
+  linkerKey(const linkerKey & other) : pEntry(other.pEntry)
+  {
+    this->pEntry->refs.fetch_add(1, std::memory_order_relaxed);
+  }
+  linkerKey(linkerKey && other) noexcept : linkerKey(std::as_const(other))
+  {
+    // Empty
+  }
+  auto operator=(const linkerKey & other) -> linkerKey &
+  {
+    if(this->pEntry != other.pEntry)
+    {
+      other.pEntry->refs.fetch_add(1, std::memory_order_relaxed);
+      linkerKey::release(this->pEntry);
+      this->pEntry = other.pEntry;
+    }
+    return *this;
+  }
+  auto operator=(linkerKey && other) noexcept -> linkerKey &
+  {
+    return *this = std::as_const(other);
+  }
+
+  [[nodiscard]] inline auto str() const -> const std::string & { return this->pEntry->name; }
+  inline operator const std::string &() const { return this->pEntry->name; }
+
+  [[nodiscard]] friend inline auto operator==(const linkerKey & lhs, const linkerKey & rhs) -> bool
+  {
+    return lhs.pEntry == rhs.pEntry;
+  }
+  // Ordered by text, objects keep writing their members alphabetically
+  [[nodiscard]] friend inline auto operator<=>(const linkerKey & lhs, const linkerKey & rhs)
+    -> std::strong_ordering
+  {
+    return lhs.pEntry == rhs.pEntry ? std::strong_ordering::equal
+                                    : lhs.pEntry->name <=> rhs.pEntry->name;
+  }
+
+  // Lookups by plain text (object_t::find("name")) do not touch the table
+  template<typename T> requires std::convertible_to<const T &, std::string_view>
+  [[nodiscard]] friend inline auto operator==(const linkerKey & lhs, const T & rhs) -> bool
+  {
+    return std::string_view(lhs.pEntry->name) == std::string_view(rhs);
+  }
+  template<typename T> requires std::convertible_to<const T &, std::string_view>
+  [[nodiscard]] friend inline auto operator<=>(const linkerKey & lhs, const T & rhs)
+    -> std::strong_ordering
+  {
+    return std::string_view(lhs.pEntry->name) <=> std::string_view(rhs);
+  }
+};
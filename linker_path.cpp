@@ -0,0 +1,102 @@
+#include "linker_path.hpp"
+
+auto linkerPath::key(std::string key) -> linkerPath
+{
+  linkerPath ret;
+  ret.m_keys.push_back(std::move(key));
+  return ret;
+}
+
+auto linkerPath::pointer(std::string_view pointer) -> linkerPath
+{
+  linkerPath ret;
+
+  if(pointer.empty())
+    return ret;
+
+  std::size_t index = (pointer.front() == '/') ? 1 : 0;
+  do
+  {
+    const std::size_t next = pointer.find('/', index);
+    std::string_view  part = pointer.substr(index, next - index);
+    std::string       key;
+
+    for(std::size_t i = 0; i < part.size(); i++)
+    {
+      if(part[i] == '~' && i + 1 < part.size() && (part[i+1] == '0' || part[i+1] == '1'))
+      {
+        key += (part[++i] == '0') ? '~' : '/';
+      }
+      else key += part[i];
+    }
+    ret.m_keys.push_back(std::move(key));
+
+    index = (next == std::string_view::npos) ? next : next + 1;
+  } while(index != std::string_view::npos);
+
+  return ret;
+}
+
+auto linkerPath::dotted(std::string_view path, char separator) -> linkerPath
+{
+  linkerPath ret;
+
+  if(path.empty())
+    return ret;
+
+  std::size_t index = 0;
+  do
+  {
+    const std::size_t next = path.find(separator, index);
+    ret.m_keys.emplace_back(path.substr(index, next - index));
+
+    index = (next == std::string_view::npos) ? next : next + 1;
+  } while(index != std::string_view::npos);
+
+  return ret;
+}
+
+auto linkerPath::index(const std::string & key) -> std::size_t
+{
+  if(key.empty() || (key.size() > 1 && key.front() == '0'))
+    return std::string::npos;
+
+  std::size_t ret = 0;
+  for(const auto sym : key)
+  {
+    if(sym < '0' || sym > '9')
+      return std::string::npos;
+
+    // Too large for any array, and npos itself stays reserved
+    const auto digit = std::size_t(sym - '0');
+    if(ret > (std::string::npos - 1 - digit) / 10)
+      return std::string::npos;
+
+    ret = ret * 10 + digit;
+  }
+  return ret;
+}
+
+auto linkerPath::child(std::string key) const -> linkerPath
+{
+  linkerPath ret = *this;
+  ret.m_keys.push_back(std::move(key));
+  return ret;
+}
+
+auto linkerPath::toPointer() const -> std::string
+{
+  std::string ret;
+
+  for(const auto & key : this->m_keys)
+  {
+    ret += '/';
+    for(const auto sym : key)
+    {
+      if(sym == '~')      ret += "~0";
+      else if(sym == '/') ret += "~1";
+      else                ret += sym;
+    }
+  }
+  return ret;
+}
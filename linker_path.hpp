@@ -0,0 +1,37 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+class linkerPath
+{
+  std::vector<std::string> m_keys;
+
+public:
+  linkerPath() = default;
+
+  // One literal key, dots and slashes are not interpreted
+  [[nodiscard]] static auto key(std::string key) -> linkerPath;
+  // RFC 6901 JSON Pointer: "/network/http/timeout", "~1" is '/', "~0" is '~'
+  [[nodiscard]] static auto pointer(std::string_view pointer) -> linkerPath;
+  // "network.http.timeout"
+  [[nodiscard]] static auto dotted(std::string_view path, char separator = '.') -> linkerPath;
+
+  [[nodiscard]] inline auto size()  const -> std::size_t { return this->m_keys.size(); }
+  [[nodiscard]] inline auto empty() const -> bool        { return this->m_keys.empty(); }
+  [[nodiscard]] inline auto front() const -> const std::string & { return this->m_keys.front(); }
+  [[nodiscard]] inline auto begin() const { return this->m_keys.cbegin(); }
+  [[nodiscard]] inline auto end()   const { return this->m_keys.cend(); }
+  [[nodiscard]] inline auto operator[](std::size_t i) const -> const std::string &
+  {
+    return this->m_keys[i];
+  }
+
+  // Array position held by a component, npos when it is not a plain number
+  [[nodiscard]] static auto index(const std::string & key) -> std::size_t;
+
+  [[nodiscard]] auto child(std::string key) const -> linkerPath;
+
+  [[nodiscard]] auto toPointer() const -> std::string;
+};
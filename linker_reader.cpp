@@ -0,0 +1,306 @@
+#include <charconv>
+
+#include "linker_reader.hpp"
+#include "linker_string.hpp"
+
+static inline auto isSpace(char sym) -> bool
+{
+  return sym == ' ' || sym == '\t' || sym == '\n' || sym == '\r';
+}
+
+// Characters that end a number or a literal
+static inline auto isDelimiter(char sym) -> bool
+{
+  return isSpace(sym) || sym == ',' || sym == ':' || sym == '\"'
+      || sym == '[' || sym == ']' || sym == '{' || sym == '}';
+}
+
+// Raw string text ending in the middle of an escape, an odd run of backslashes
+static auto openEscape(std::string_view raw) -> bool
+{
+  std::size_t count = 0;
+  while(count < raw.size() && raw[raw.size() - 1 - count] == '\\') count++;
+
+  return count % 2 == 1;
+}
+
+//--------------------------------------------------------------------------------------------------
+linkerReader::linkerReader(Visitor & visitor) : m_visitor(visitor)
+{
+  // Empty
+}
+
+auto linkerReader::read(std::string_view text, Visitor & visitor) -> std::optional<linker::Error>
+{
+  linkerReader reader { visitor };
+  reader.feed(text);
+
+  return reader.finish();
+}
+
+auto linkerReader::read(std::istream & in, Visitor & visitor) -> std::optional<linker::Error>
+{
+  linkerReader reader { visitor };
+  std::string  buffer(linkerReader::chunk, '\0');
+
+  while(in.read(buffer.data(), (std::streamsize)buffer.size()) || in.gcount() > 0)
+  {
+    if(!reader.feed({ buffer.data(), std::size_t(in.gcount()) }))
+      break;
+  }
+  return reader.finish();
+}
+
+//--------------------------------------------------------------------------------------------------
+auto linkerReader::feed(std::string_view text) -> bool
+{
+  if(this->m_error || this->m_stopped)
+    return false;
+
+  std::size_t pos = (this->m_pending != Pending::None) ? this->resume(text) : 0;
+
+  while(pos < text.size() && !this->m_error && !this->m_stopped)
+  {
+    const char sym = text[pos];
+    if(isSpace(sym))
+    {
+      pos++;
+      continue;
+    }
+
+    const std::size_t offset = this->m_offset + pos;
+
+    switch(this->m_expect)
+    {
+    case Expect::Value:
+    case Expect::ValueOrEnd: {
+      if(sym == '{' || sym == '[')
+      {
+        this->m_stack.push_back(sym);
+        this->m_expect = (sym == '{') ? Expect::KeyOrEnd : Expect::ValueOrEnd;
+
+        if(!(sym == '{' ? this->m_visitor.startObject() : this->m_visitor.startArray()))
+          this->m_stopped = true;
+        pos++;
+      }
+      else if(sym == ']' && this->m_expect == Expect::ValueOrEnd)
+      {
+        this->close(sym, offset);
+        pos++;
+      }
+      else if(sym == '\"')      pos = this->string(text, pos, false);
+      else if(isDelimiter(sym)) this->fail(offset);
+      else                      pos = this->word(text, pos);
+    } break;
+    case Expect::Key:
+    case Expect::KeyOrEnd: {
+      if(sym == '\"')
+      {
+        pos = this->string(text, pos, true);
+      }
+      else if(sym == '}' && this->m_expect == Expect::KeyOrEnd)
+      {
+        this->close(sym, offset);
+        pos++;
+      }
+      else this->fail(offset);
+    } break;
+    case Expect::Colon: {
+      if(sym == ':')
+      {
+        this->m_expect = Expect::Value;
+        pos++;
+      }
+      else this->fail(offset);
+    } break;
+    case Expect::Next: {
+      if(sym == ',')
+      {
+        this->m_expect = (this->m_stack.back() == '{') ? Expect::Key : Expect::Value;
+        pos++;
+      }
+      else if(sym == '}' || sym == ']')
+      {
+        this->close(sym, offset);
+        pos++;
+      }
+      else this->fail(offset);
+    } break;
+    case Expect::Done: {
+      this->fail(offset);
+    } break;
+    }
+  }
+
+  this->m_offset += text.size();
+  return !this->m_error && !this->m_stopped;
+}
+
+auto linkerReader::finish() -> std::optional<linker::Error>
+{
+  if(!this->m_error && !this->m_stopped)
+  {
+    if(this->m_pending == Pending::Word)
+    {
+      this->m_pending = Pending::None;
+      this->emitWord(this->m_token);
+      this->m_token.clear();
+    }
+    else if(this->m_pending != Pending::None)
+    {
+      this->fail(this->m_start);
+    }
+
+    if(this->m_expect != Expect::Done && !this->m_stopped)
+      this->fail(this->m_offset);
+  }
+  return this->m_error;
+}
+
+//--------------------------------------------------------------------------------------------------
+void linkerReader::fail(std::size_t offset)
+{
+  if(!this->m_error)
+    this->m_error = linker::Error { linker::Error::Code::Parse, {}, offset };
+}
+
+// A value is complete, going is what the visitor answered to it
+void linkerReader::next(bool going)
+{
+  if(!going) this->m_stopped = true;
+
+  this->m_expect = this->m_stack.empty() ? Expect::Done : Expect::Next;
+}
+
+void linkerReader::close(char sym, std::size_t offset)
+{
+  if(this->m_stack.empty() || this->m_stack.back() != (sym == '}' ? '{' : '['))
+  {
+    this->fail(offset);
+    return;
+  }
+
+  this->m_stack.pop_back();
+  this->next(sym == '}' ? this->m_visitor.endObject() : this->m_visitor.endArray());
+}
+
+auto linkerReader::string(std::string_view text, std::size_t pos, bool isKey) -> std::size_t
+{
+  const std::size_t end = linkerString::end(text, pos + 1);
+
+  // Whole string in this chunk, handed out without a copy unless it has escapes
+  if(end != std::string_view::npos)
+  {
+    this->emitString(text.substr(pos + 1, end - pos - 1), isKey);
+    return end + 1;
+  }
+
+  this->m_pending = isKey ? Pending::Key : Pending::String;
+  this->m_start   = this->m_offset + pos;
+  this->m_token.assign(text.substr(pos + 1));
+
+  return std::string_view::npos;
+}
+
+auto linkerReader::resume(std::string_view text) -> std::size_t
+{
+  if(this->m_pending == Pending::Word)
+    return this->word(text, 0);
+
+  std::size_t pos = 0;
+
+  // The previous chunk ended on a backslash, its escaped character comes first
+  if(openEscape(this->m_token))
+  {
+    if(text.empty()) return std::string_view::npos;
+
+    this->m_token += text[0];
+    pos = 1;
+  }
+
+  const std::size_t end = linkerString::end(text, pos);
+  if(end == std::string_view::npos)
+  {
+    this->m_token.append(text.substr(pos));
+    return end;
+  }
+
+  this->m_token.append(text.substr(pos, end - pos));
+
+  const bool isKey = (this->m_pending == Pending::Key);
+  this->m_pending  = Pending::None;
+
+  this->emitString(this->m_token, isKey);
+  this->m_token.clear();
+
+  return end + 1;
+}
+
+auto linkerReader::word(std::string_view text, std::size_t pos) -> std::size_t
+{
+  std::size_t end = pos;
+  while(end < text.size() && !isDelimiter(text[end])) end++;
+
+  if(this->m_pending != Pending::Word)
+    this->m_start = this->m_offset + pos;
+
+  if(end == text.size())
+  {
+    this->m_pending = Pending::Word;
+    this->m_token.append(text.substr(pos));
+    return std::string_view::npos;
+  }
+
+  if(this->m_pending == Pending::Word)
+  {
+    this->m_pending = Pending::None;
+    this->m_token.append(text.substr(pos, end - pos));
+    this->emitWord(this->m_token);
+    this->m_token.clear();
+  }
+  else this->emitWord(text.substr(pos, end - pos));
+
+  return end;
+}
+
+void linkerReader::emitString(std::string_view raw, bool isKey)
+{
+  std::string_view text = raw;
+
+  if(raw.find('\\') != std::string_view::npos)
+  {
+    this->m_scratch.clear();
+    linkerString::unescape(raw, this->m_scratch);
+    text = this->m_scratch;
+  }
+
+  if(isKey)
+  {
+    if(!this->m_visitor.key(text)) this->m_stopped = true;
+    this->m_expect = Expect::Colon;
+  }
+  else this->next(this->m_visitor.string(text));
+}
+
+void linkerReader::emitWord(std::string_view word)
+{
+  if(word == "true" || word == "false")
+  {
+    this->next(this->m_visitor.boolean(word == "true"));
+  }
+  else if(word == "null")
+  {
+    this->next(this->m_visitor.null());
+  }
+  else
+  {
+    // Strict as in validate(), the whole token has to be the number ("12abc" is an error)
+    linker::number_t value {};
+    const auto result = std::from_chars(word.data(), word.data() + word.size(), value);
+
+    if(result.ec == std::errc() && result.ptr == word.data() + word.size())
+      this->next(this->m_visitor.number(value));
+    else
+      this->fail(this->m_start);
+  }
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <istream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "linker.hpp"
+
+// Event driven JSON reader. Text is pushed in chunks of any size and reported to a Visitor as
+// it is read, no tree is built. Memory is bounded by the nesting depth and the longest single
+// string or number, so a store of any size is scanned with a constant working set
+class linkerReader
+{
+public:
+  // Every callback returns whether to go on, false stops the reader (which is not an error).
+  // Texts are only valid during the call
+  class Visitor
+  {
+  public:
+    Visitor() = default;
+    Visitor(Visitor &&) noexcept = default;
+    Visitor(const Visitor &) = default;
+    auto operator=(Visitor &&) noexcept -> Visitor & = default;
+    auto operator=(const Visitor &) -> Visitor & = default;
+    virtual ~Visitor() = default;
+
+    virtual auto startObject()                  -> bool { return true; }
+    virtual auto endObject()                    -> bool { return true; }
+    virtual auto startArray()                   -> bool { return true; }
+    virtual auto endArray()                     -> bool { return true; }
+    virtual auto key(std::string_view)          -> bool { return true; }
+    virtual auto null()                         -> bool { return true; }
+    virtual auto boolean(bool)                  -> bool { return true; }
+    virtual auto number(linker::number_t)       -> bool { return true; }
+    virtual auto string(std::string_view)       -> bool { return true; }
+  };
+
+  static constexpr std::size_t chunk = 64 * 1024;
+
+  explicit linkerReader(Visitor & visitor);
+
+  // False once the text is malformed or the visitor stopped, later chunks are ignored
+  auto feed(std::string_view text) -> bool;
+  // Ends the text, reports what is malformed or left open
+  [[nodiscard]] auto finish() -> std::optional<linker::Error>;
+
+  [[nodiscard]] inline auto stopped() const -> bool
+  {
+    return this->m_stopped;
+  }
+
+  [[nodiscard]] static auto read(std::string_view text, Visitor & visitor) -> std::optional<linker::Error>;
+  // Pulls the stream a chunk at a time
+  [[nodiscard]] static auto read(std::istream & in, Visitor & visitor) -> std::optional<linker::Error>;
+
+private:
+  enum class Expect : uint8_t
+  {
+    Value,
+    ValueOrEnd,
+    Key,
+    KeyOrEnd,
+    Colon,
+    Next,
+    Done
+  };
+  // Token cut off by the end of a chunk
+  enum class Pending : uint8_t
+  {
+    None,
+    String,
+    Key,
+    Word
+  };
+
+  Visitor &         m_visitor;
+  std::vector<char> m_stack;
+  Expect            m_expect  = Expect::Value;
+  Pending           m_pending = Pending::None;
+  // Raw text of the pending token, escapes included
+  std::string       m_token;
+  std::string       m_scratch;
+  // Offset of the current chunk in the whole text, and of the pending token
+  std::size_t       m_offset  = 0;
+  std::size_t       m_start   = 0;
+  bool              m_stopped = false;
+
+  std::optional<linker::Error> m_error;
+
+  void fail(std::size_t offset);
+  void next(bool going);
+  void close(char sym, std::size_t offset);
+
+  // Each returns where reading goes on in text, npos when the token continues in the next chunk
+  auto string(std::string_view text, std::size_t pos, bool isKey) -> std::size_t;
+  auto resume(std::string_view text) -> std::size_t;
+  auto word(std::string_view text, std::size_t pos) -> std::size_t;
+
+  void emitString(std::string_view raw, bool isKey);
+  void emitWord(std::string_view word);
+};
@@ -0,0 +1,232 @@
+#include <bit>
+#include <cstdint>
+
+#include "linker_string.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define LINKER_STRING_SSE2 1
+#  include <emmintrin.h>
+#else
+#  define LINKER_STRING_SSE2 0
+#endif
+
+static inline auto needsEscape(char sym) -> bool
+{
+  return sym == '\"' || sym == '\\' || (unsigned char)sym < 0x20;
+}
+
+// First position from pos holding a quote, a backslash or a control character
+static auto findEscape(std::string_view text, std::size_t pos) -> std::size_t
+{
+#if LINKER_STRING_SSE2
+  const __m128i quote = _mm_set1_epi8('\"');
+  const __m128i slash = _mm_set1_epi8('\\');
+  const __m128i ctrl  = _mm_set1_epi8(0x1f);
+
+  for(; pos + 16 <= text.size(); pos += 16)
+  {
+    const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text.data() + pos));
+    const __m128i hit   = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, quote),
+                                                    _mm_cmpeq_epi8(block, slash)),
+                                       _mm_cmpeq_epi8(_mm_min_epu8(block, ctrl), block));
+
+    if(const int mask = _mm_movemask_epi8(hit))
+      return pos + std::size_t(std::countr_zero(unsigned(mask)));
+  }
+#endif
+  for(; pos < text.size(); pos++)
+  {
+    if(needsEscape(text[pos])) return pos;
+  }
+  return text.size();
+}
+
+// First position from pos holding a backslash, or a quote as well when quotes is set
+static auto findSpecial(std::string_view text, std::size_t pos, bool quotes) -> std::size_t
+{
+#if LINKER_STRING_SSE2
+  const __m128i quote = _mm_set1_epi8(quotes ? '\"' : '\\');
+  const __m128i slash = _mm_set1_epi8('\\');
+
+  for(; pos + 16 <= text.size(); pos += 16)
+  {
+    const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text.data() + pos));
+    const __m128i hit   = _mm_or_si128(_mm_cmpeq_epi8(block, quote), _mm_cmpeq_epi8(block, slash));
+
+    if(const int mask = _mm_movemask_epi8(hit))
+      return pos + std::size_t(std::countr_zero(unsigned(mask)));
+  }
+#endif
+  for(; pos < text.size(); pos++)
+  {
+    if(text[pos] == '\\' || (quotes && text[pos] == '\"')) return pos;
+  }
+  return text.size();
+}
+
+// Four hex digits at pos, -1 when they are not there
+static auto readHex(std::string_view text, std::size_t pos) -> long
+{
+  if(pos + 4 > text.size())
+    return -1;
+
+  long value = 0;
+  for(std::size_t i = pos; i < pos + 4; i++)
+  {
+    const char sym = text[i];
+    value <<= 4;
+
+    if(sym >= '0' && sym <= '9')      value |= sym - '0';
+    else if(sym >= 'a' && sym <= 'f') value |= sym - 'a' + 10;
+    else if(sym >= 'A' && sym <= 'F') value |= sym - 'A' + 10;
+    else return -1;
+  }
+  return value;
+}
+
+static void appendUTF8(uint32_t code, std::string & out)
+{
+  if(code < 0x80)
+  {
+    out += char(code);
+  }
+  else if(code < 0x800)
+  {
+    out += char(0xc0 | (code >> 6));
+    out += char(0x80 | (code & 0x3f));
+  }
+  else if(code < 0x10000)
+  {
+    out += char(0xe0 | (code >> 12));
+    out += char(0x80 | ((code >> 6) & 0x3f));
+    out += char(0x80 | (code & 0x3f));
+  }
+  else
+  {
+    out += char(0xf0 | (code >> 18));
+    out += char(0x80 | ((code >> 12) & 0x3f));
+    out += char(0x80 | ((code >> 6) & 0x3f));
+    out += char(0x80 | (code & 0x3f));
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+void linkerString::escape(std::string_view text, std::string & out)
+{
+  static constexpr char hex[] = "0123456789abcdef";
+
+  std::size_t pos = 0;
+  while(pos < text.size())
+  {
+    const std::size_t hit = findEscape(text, pos);
+    out.append(text.data() + pos, hit - pos);
+
+    if(hit == text.size())
+      break;
+
+    const char sym = text[hit];
+    switch(sym)
+    {
+    case '\"': out += "\\\""; break;
+    case '\\': out += "\\\\"; break;
+    case '\b': out += "\\b";  break;
+    case '\f': out += "\\f";  break;
+    case '\n': out += "\\n";  break;
+    case '\r': out += "\\r";  break;
+    case '\t': out += "\\t";  break;
+    default: {
+      out += "\\u00";
+      out += hex[(unsigned char)sym >> 4];
+      out += hex[(unsigned char)sym & 0xf];
+    } break;
+    }
+    pos = hit + 1;
+  }
+}
+
+void linkerString::unescape(std::string_view body, std::string & out)
+{
+  out.reserve(out.size() + body.size());
+
+  std::size_t pos = 0;
+  while(pos < body.size())
+  {
+    const std::size_t hit = findSpecial(body, pos, false);
+    out.append(body.data() + pos, hit - pos);
+
+    if(hit == body.size())
+      break;
+
+    // A trailing backslash is kept as it is
+    if(hit + 1 == body.size())
+    {
+      out += '\\';
+      break;
+    }
+
+    const char sym = body[hit + 1];
+    pos = hit + 2;
+
+    switch(sym)
+    {
+    case 'b': out += '\b'; break;
+    case 'f': out += '\f'; break;
+    case 'n': out += '\n'; break;
+    case 'r': out += '\r'; break;
+    case 't': out += '\t'; break;
+    case 'u': {
+      const long unit = readHex(body, pos);
+      if(unit < 0)
+      {
+        out += sym;
+        break;
+      }
+      pos += 4;
+
+      uint32_t code = uint32_t(unit);
+      if(code >= 0xd800 && code <= 0xdbff)
+      {
+        const long low = (pos + 1 < body.size() && body[pos] == '\\' && body[pos + 1] == 'u')
+                       ? readHex(body, pos + 2) : -1;
+
+        if(low >= 0xdc00 && low <= 0xdfff)
+        {
+          code = 0x10000 + ((code - 0xd800) << 10) + (uint32_t(low) - 0xdc00);
+          pos += 6;
+        }
+        else code = 0xfffd;
+      }
+      else if(code >= 0xdc00 && code <= 0xdfff)
+      {
+        code = 0xfffd;
+      }
+      appendUTF8(code, out);
+    } break;
+    default: {
+      out += sym;
+    } break;
+    }
+  }
+}
+
+auto linkerString::unescape(std::string_view body) -> std::string
+{
+  std::string ret;
+  linkerString::unescape(body, ret);
+
+  return ret;
+}
+
+auto linkerString::end(std::string_view input, std::size_t pos) -> std::size_t
+{
+  while(pos < input.size())
+  {
+    pos = findSpecial(input, pos, true);
+
+    if(pos == input.size()) break;
+    if(input[pos] == '\"')  return pos;
+
+    pos += 2;
+  }
+  return std::string_view::npos;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+// Body of a JSON string, the text between its quotes. Runs without anything to escape are
+// found 16 bytes at a time (SSE2 when the target has it) and copied in one go
+class linkerString
+{
+public:
+  // Appends text with quotes, backslashes and control characters escaped
+  static void escape(std::string_view text, std::string & out);
+
+  // Appends the decoded body: \" \\ \/ \b \f \n \r \t and \uXXXX, surrogate pairs are joined
+  // and lone halves become U+FFFD, any other escaped character is taken literally
+  static void unescape(std::string_view body, std::string & out);
+  [[nodiscard]] static auto unescape(std::string_view body) -> std::string;
+
+  // Position of the quote ending the string whose body starts at pos, npos when there is none
+  [[nodiscard]] static auto end(std::string_view input, std::size_t pos) -> std::size_t;
+};
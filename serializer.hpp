@@ -84,22 +84,16 @@ private:
 
     void copy_from(const linker::object_t & map) const override
     {
-      bool contains = false;
-      if(!map.empty())
+      auto it = map.find(this->name());
+      if(it == map.end())
       {
-        for(auto & pair : map)
-        {
-          if(pair.first == this->name())
-            contains = true;
-        }
-      }
-
-      if(contains)
-      {
-        this->write(linker::value<Type>(map.at(this->name())));
+        this->toDefValue();
         return;
       }
-      this->toDefValue();
+
+      // Plain members are filled in place and keep their storage
+      if(this->pPtr && !this->fSet) it->second >> *this->pPtr;
+      else                          this->write(linker::value<Type>(it->second));
     }
     void copy_to(linker::object_t & map) const override
     {
@@ -139,14 +133,9 @@ private:
     }
     auto m_setDefValue(const std::any & defValue) -> PropertyBase & override
     {
-      try
-      {
-        this->defValue = std::any_cast<Type>(defValue);
-      }
-      catch(...)
-      {
-        // Empty
-      }
+      // A default of another type is ignored
+      if(const auto * pValue = std::any_cast<Type>(&defValue))
+        this->defValue = *pValue;
 
       return *this;
     }
@@ -0,0 +1,307 @@
+#include <algorithm>
+#include <array>
+#include <limits>
+
+#include "store_codec.hpp"
+
+#if STORE_SETTINGS_ZLIB
+#  include <zlib.h>
+#endif
+
+// Largest expansion of deflate, the most a gzip file can claim to hold per byte
+static constexpr std::size_t maxRatio = 1032;
+
+auto StoreCodec::available(Type type) -> bool
+{
+  switch(type)
+  {
+  case Type::None: return true;
+  case Type::Gzip: return STORE_SETTINGS_ZLIB;
+  }
+  return false;
+}
+
+auto StoreCodec::detect(std::string_view data) -> Type
+{
+  if(data.size() >= 2 && (unsigned char)data[0] == 0x1f && (unsigned char)data[1] == 0x8b)
+    return Type::Gzip;
+
+  return Type::None;
+}
+
+auto StoreCodec::decode(std::string & data) -> bool
+{
+  if(StoreCodec::detect(data) == Type::None)
+    return true;
+
+#if STORE_SETTINGS_ZLIB
+  z_stream stream {};
+  if(inflateInit2(&stream, 15 + 16) != Z_OK)
+    return false;
+
+  // The gzip trailer ends with the text size modulo 2^32, a good first guess. It is not trusted
+  // past maxRatio, a corrupt trailer costs doublings of the buffer instead of a 4 GiB allocation
+  std::size_t hint = 0;
+  if(data.size() >= 4)
+  {
+    const auto * pTail = reinterpret_cast<const unsigned char *>(data.data() + data.size() - 4);
+    hint = std::size_t(pTail[0]) | std::size_t(pTail[1]) << 8
+         | std::size_t(pTail[2]) << 16 | std::size_t(pTail[3]) << 24;
+    hint = std::min(hint, data.size() * maxRatio);
+  }
+
+  std::string text;
+  text.resize(std::max(hint, data.size() * 2) + 1);
+
+  std::size_t inPos  = 0;
+  std::size_t outPos = 0;
+  int         result = Z_OK;
+
+  while(result == Z_OK)
+  {
+    if(outPos == text.size())
+      text.resize(text.size() * 2);
+
+    const auto inChunk  = std::min<std::size_t>(data.size() - inPos, std::numeric_limits<uInt>::max());
+    const auto outChunk = std::min<std::size_t>(text.size() - outPos, std::numeric_limits<uInt>::max());
+
+    stream.next_in   = reinterpret_cast<Bytef *>(data.data() + inPos);
+    stream.avail_in  = uInt(inChunk);
+    stream.next_out  = reinterpret_cast<Bytef *>(text.data() + outPos);
+    stream.avail_out = uInt(outChunk);
+
+    result = inflate(&stream, Z_NO_FLUSH);
+
+    inPos  += inChunk  - stream.avail_in;
+    outPos += outChunk - stream.avail_out;
+
+    if(result == Z_BUF_ERROR && stream.avail_out != 0)
+      break;
+    if(result == Z_BUF_ERROR)
+      result = Z_OK;
+  }
+  inflateEnd(&stream);
+
+  if(result != Z_STREAM_END)
+    return false;
+
+  text.resize(outPos);
+  data = std::move(text);
+  return true;
+#else
+  return false;
+#endif
+}
+
+//--------------------------------------------------------------------------------------------------
+struct StoreCodec::Encoder::State
+{
+#if STORE_SETTINGS_ZLIB
+  z_stream                stream {};
+  std::array<char, 65536> buffer;
+#endif
+};
+
+StoreCodec::Encoder::Encoder(std::ostream & out, Type type, int level)
+  : m_out(out), m_type(StoreCodec::available(type) ? type : Type::None)
+{
+#if STORE_SETTINGS_ZLIB
+  if(this->m_type == Type::Gzip)
+  {
+    this->pState = std::make_unique<State>();
+    this->m_ok   = deflateInit2(&this->pState->stream, level, Z_DEFLATED, 15 + 16, 8,
+                                Z_DEFAULT_STRATEGY) == Z_OK;
+    if(!this->m_ok)
+      this->pState.reset();
+  }
+#else
+  (void)level;
+#endif
+}
+
+StoreCodec::Encoder::~Encoder()
+{
+#if STORE_SETTINGS_ZLIB
+  if(this->pState)
+    deflateEnd(&this->pState->stream);
+#endif
+}
+
+void StoreCodec::Encoder::put(const char * data, std::size_t size)
+{
+  this->m_out.write(data, (std::streamsize)size);
+  this->m_written += size;
+
+  if(!this->m_out) this->m_ok = false;
+}
+
+void StoreCodec::Encoder::write(std::string_view text)
+{
+  if(!this->m_ok || text.empty())
+    return;
+
+  if(this->m_type == Type::None)
+  {
+    this->put(text.data(), text.size());
+    return;
+  }
+
+#if STORE_SETTINGS_ZLIB
+  auto & stream = this->pState->stream;
+  auto & buffer = this->pState->buffer;
+
+  while(!text.empty() && this->m_ok)
+  {
+    const auto chunk = std::min<std::size_t>(text.size(), std::numeric_limits<uInt>::max());
+
+    stream.next_in  = reinterpret_cast<Bytef *>(const_cast<char *>(text.data()));
+    stream.avail_in = uInt(chunk);
+
+    do
+    {
+      stream.next_out  = reinterpret_cast<Bytef *>(buffer.data());
+      stream.avail_out = uInt(buffer.size());
+
+      if(deflate(&stream, Z_NO_FLUSH) == Z_STREAM_ERROR)
+      {
+        this->m_ok = false;
+        return;
+      }
+      this->put(buffer.data(), buffer.size() - stream.avail_out);
+    }
+    while(stream.avail_out == 0 && this->m_ok);
+
+    text.remove_prefix(chunk);
+  }
+#endif
+}
+
+auto StoreCodec::Encoder::finish() -> bool
+{
+#if STORE_SETTINGS_ZLIB
+  if(this->pState && this->m_ok)
+  {
+    auto & stream = this->pState->stream;
+    auto & buffer = this->pState->buffer;
+    int    result = Z_OK;
+
+    stream.next_in  = nullptr;
+    stream.avail_in = 0;
+
+    while(result == Z_OK && this->m_ok)
+    {
+      stream.next_out  = reinterpret_cast<Bytef *>(buffer.data());
+      stream.avail_out = uInt(buffer.size());
+
+      result = deflate(&stream, Z_FINISH);
+      this->put(buffer.data(), buffer.size() - stream.avail_out);
+    }
+    if(result != Z_STREAM_END)
+      this->m_ok = false;
+
+    deflateEnd(&stream);
+    this->pState.reset();
+  }
+#endif
+  this->m_out.flush();
+  return this->m_ok && this->m_out.good();
+}
+
+//--------------------------------------------------------------------------------------------------
+struct StoreCodec::Decoder::State
+{
+#if STORE_SETTINGS_ZLIB
+  z_stream                stream {};
+  std::array<char, 65536> buffer;
+  bool                    ended = false;
+#endif
+};
+
+StoreCodec::Decoder::Decoder(Type type) : m_type(type)
+{
+  if(type == Type::None)
+    return;
+
+#if STORE_SETTINGS_ZLIB
+  this->pState = std::make_unique<State>();
+  this->m_ok   = inflateInit2(&this->pState->stream, 15 + 16) == Z_OK;
+  if(!this->m_ok)
+    this->pState.reset();
+#else
+  this->m_ok = false;
+#endif
+}
+
+StoreCodec::Decoder::~Decoder()
+{
+#if STORE_SETTINGS_ZLIB
+  if(this->pState)
+    inflateEnd(&this->pState->stream);
+#endif
+}
+
+auto StoreCodec::Decoder::write(std::string_view data, const Sink & out) -> bool
+{
+  if(!this->m_ok)
+    return false;
+
+  if(this->m_type == Type::None)
+  {
+    if(!data.empty()) out(data);
+    return true;
+  }
+
+#if STORE_SETTINGS_ZLIB
+  auto & stream = this->pState->stream;
+  auto & buffer = this->pState->buffer;
+
+  // Bytes after the end of the stream are ignored, as decode() does
+  while(!data.empty() && !this->pState->ended)
+  {
+    const auto chunk = std::min<std::size_t>(data.size(), std::numeric_limits<uInt>::max());
+
+    stream.next_in  = reinterpret_cast<Bytef *>(const_cast<char *>(data.data()));
+    stream.avail_in = uInt(chunk);
+
+    do
+    {
+      stream.next_out  = reinterpret_cast<Bytef *>(buffer.data());
+      stream.avail_out = uInt(buffer.size());
+
+      const int result = inflate(&stream, Z_NO_FLUSH);
+      if(result != Z_OK && result != Z_STREAM_END && result != Z_BUF_ERROR)
+      {
+        this->m_ok = false;
+        return false;
+      }
+
+      if(const std::size_t size = buffer.size() - stream.avail_out)
+        out({ buffer.data(), size });
+
+      if(result == Z_STREAM_END)
+      {
+        this->pState->ended = true;
+        break;
+      }
+    }
+    while(stream.avail_out == 0);
+
+    data.remove_prefix(chunk);
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
+auto StoreCodec::Decoder::finish() const -> bool
+{
+  if(!this->m_ok)
+    return false;
+
+#if STORE_SETTINGS_ZLIB
+  return this->m_type == Type::None || this->pState->ended;
+#else
+  return this->m_type == Type::None;
+#endif
+}
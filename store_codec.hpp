@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+// zlib is used when its header is found (link with -lz),
+// define STORE_SETTINGS_NO_ZLIB to build without it
+#if !defined(STORE_SETTINGS_NO_ZLIB) && __has_include(<zlib.h>)
+#  define STORE_SETTINGS_ZLIB 1
+#else
+#  define STORE_SETTINGS_ZLIB 0
+#endif
+
+class StoreCodec
+{
+public:
+  enum class Type : uint8_t
+  {
+    None,
+    Gzip
+  };
+
+  [[nodiscard]] static auto available(Type type) -> bool;
+  // Format of stored bytes, told apart by their magic header (JSON text never starts with one)
+  [[nodiscard]] static auto detect(std::string_view data) -> Type;
+  // Replaces encoded data with its text, false when it is corrupt or the codec is missing
+  [[nodiscard]] static auto decode(std::string & data) -> bool;
+
+  // Encodes the text written to it straight into out, a chunk at a time
+  class Encoder
+  {
+    struct State;
+
+    std::ostream &         m_out;
+    Type                   m_type;
+    std::size_t            m_written = 0;
+    bool                   m_ok      = true;
+    std::unique_ptr<State> pState;
+
+    void put(const char * data, std::size_t size);
+
+  public:
+    Encoder(std::ostream & out, Type type, int level);
+    ~Encoder();
+    Encoder(Encoder &&) = delete;
+    Encoder(const Encoder &) = delete;
+    auto operator=(Encoder &&) -> Encoder & = delete;
+    auto operator=(const Encoder &) -> Encoder & = delete;
+
+    void write(std::string_view text);
+    // Writes what the codec still buffers, false when any step failed
+    [[nodiscard]] auto finish() -> bool;
+
+    // Bytes handed to the stream so far
+    [[nodiscard]] inline auto written() const -> std::size_t
+    {
+      return this->m_written;
+    }
+  };
+
+  // Decodes stored bytes pushed to it a chunk at a time, the text is handed out as it comes
+  class Decoder
+  {
+    struct State;
+
+    Type                   m_type;
+    bool                   m_ok = true;
+    std::unique_ptr<State> pState;
+
+  public:
+    using Sink = std::function<void(std::string_view)>;
+
+    explicit Decoder(Type type);
+    ~Decoder();
+    Decoder(Decoder &&) = delete;
+    Decoder(const Decoder &) = delete;
+    auto operator=(Decoder &&) -> Decoder & = delete;
+    auto operator=(const Decoder &) -> Decoder & = delete;
+
+    // False once the data is corrupt or the codec is missing
+    auto write(std::string_view data, const Sink & out) -> bool;
+    // False when the data was cut short or failed to decode
+    [[nodiscard]] auto finish() const -> bool;
+  };
+};
@@ -0,0 +1,93 @@
+#include <functional>
+#include <iomanip>
+#include <thread>
+
+#include "linker_string.hpp"
+#include "store_observer.hpp"
+
+#if __has_include(<unistd.h>) && !defined(_WIN32)
+#  include <unistd.h>
+#elif defined(_WIN32)
+#  include <process.h>
+#endif
+
+static auto escape(std::string_view str) -> std::string
+{
+  std::string ret;
+  ret.reserve(str.size());
+
+  linkerString::escape(str, ret);
+  return ret;
+}
+
+// Trace viewers group events by pid, a platform without one gets a single process
+static auto processId() -> long
+{
+#if __has_include(<unistd.h>) && !defined(_WIN32)
+  return long(::getpid());
+#elif defined(_WIN32)
+  return long(::_getpid());
+#else
+  return 1;
+#endif
+}
+
+auto StoreObserver::name(Stage stage) -> std::string_view
+{
+  switch(stage)
+  {
+  case Stage::GetFile:  return "getFile";
+  case Stage::FromJSON: return "fromJSON";
+  case Stage::ToJSON:   return "toJSON";
+  case Stage::SetFile:  return "setFile";
+  case Stage::MkDir:    return "mkDir";
+  }
+  return "";
+}
+
+//--------------------------------------------------------------------------------------------------
+ChromeTraceObserver::ChromeTraceObserver(const std::filesystem::path & path) : m_file(path)
+{
+  this->m_file << std::fixed << std::setprecision(3) << "{\"traceEvents\":[";
+}
+
+ChromeTraceObserver::~ChromeTraceObserver()
+{
+  std::lock_guard lock { this->m_mutex };
+
+  this->m_file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+  this->m_file.close();
+}
+
+void ChromeTraceObserver::onBegin(const Event & /*event*/)
+{
+  // Complete ("X") events are emitted once the stage has finished
+}
+
+void ChromeTraceObserver::onEnd(const Event & event)
+{
+  using us = std::chrono::duration<double, std::micro>;
+
+  const auto ts  = us(event.start - this->m_origin).count();
+  const auto dur = us(event.duration).count();
+  const auto tid = std::hash<std::thread::id>()(std::this_thread::get_id()) & 0x7fffffff;
+
+  std::lock_guard lock { this->m_mutex };
+
+  this->m_file << (this->m_first ? "\n" : ",\n")
+               << "{\"name\":\"" << StoreObserver::name(event.stage) << "\","
+               << "\"cat\":\"StoreSettings\",\"ph\":\"X\","
+               << "\"ts\":" << ts << ",\"dur\":" << dur << ","
+               << "\"pid\":" << processId() << ",\"tid\":" << tid << ","
+               << "\"args\":{\"path\":\"" << escape(event.path) << "\","
+               << "\"key\":\"" << escape(event.key) << "\","
+               << "\"bytes\":" << event.bytes << "}}";
+
+  this->m_first = false;
+}
+
+void ChromeTraceObserver::flush()
+{
+  std::lock_guard lock { this->m_mutex };
+  this->m_file.flush();
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+class StoreObserver
+{
+public:
+  enum class Stage : uint8_t
+  {
+    GetFile,
+    FromJSON,
+    ToJSON,
+    SetFile,
+    MkDir
+  };
+
+  struct Event
+  {
+    Stage            stage;
+    std::string_view path;
+    std::string_view key;
+    std::size_t      bytes = 0;
+
+    std::chrono::steady_clock::time_point start;
+    std::chrono::nanoseconds              duration {};
+  };
+
+  StoreObserver() = default;
+  StoreObserver(StoreObserver &&) noexcept = default;
+  StoreObserver(const StoreObserver &) = default;
+  auto operator=(StoreObserver &&) noexcept -> StoreObserver & = default;
+  auto operator=(const StoreObserver &) -> StoreObserver & = default;
+  virtual ~StoreObserver() = default;
+
+  virtual void onBegin(const Event & event) = 0;
+  virtual void onEnd(const Event & event)   = 0;
+
+  [[nodiscard]] static auto name(Stage stage) -> std::string_view;
+};
+
+// Writes every finished stage as a Chrome trace event ("ph":"X"),
+// loadable in chrome://tracing or Perfetto
+class ChromeTraceObserver : public StoreObserver
+{
+  std::mutex    m_mutex;
+  std::ofstream m_file;
+  bool          m_first = true;
+
+  std::chrono::steady_clock::time_point m_origin = std::chrono::steady_clock::now();
+
+public:
+  ChromeTraceObserver(const std::filesystem::path & path);
+  ChromeTraceObserver(ChromeTraceObserver &&) = delete;
+  ChromeTraceObserver(const ChromeTraceObserver &) = delete;
+  auto operator=(ChromeTraceObserver &&) -> ChromeTraceObserver & = delete;
+  auto operator=(const ChromeTraceObserver &) -> ChromeTraceObserver & = delete;
+  ~ChromeTraceObserver() override;
+
+  void onBegin(const Event & event) override;
+  void onEnd(const Event & event) override;
+
+  void flush();
+};
@@ -1,9 +1,25 @@
-#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
 #include <fstream>
+#include <mutex>
+#include <thread>
+#include <utility>
 
 #include "store_settings.hpp"
 #include "linker_file.hpp"
 
+#if __has_include(<sys/stat.h>) && !defined(_WIN32)
+#  define STORE_SETTINGS_POSIX 1
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#else
+#  define STORE_SETTINGS_POSIX 0
+#endif
+
 static auto setup_path(const std::string & path) -> std::string
 {
   std::size_t index = path.find_last_of("\\/");
@@ -35,7 +51,7 @@ static auto setup_dir(const std::string & path, const fs::path & dir)
     subdir = path.substr(indexp0, indexp1);
   }
 
-  if(subdir.back() != '\\' && subdir.back() != '/')
+  if(!subdir.empty() && subdir.back() != '\\' && subdir.back() != '/')
   {
       subdir += "/";
   }
@@ -43,40 +59,334 @@ static auto setup_dir(const std::string & path, const fs::path & dir)
   return ret + subdir;
 }
 
+// A top-level member kept in a side file is replaced by { "$external": "<side file name>" }
+static const std::string           externalKey = "$external";
+static constexpr std::string_view externalTag = "\"$external\"";
+
+// Side file name held by a reference node, empty for any other node
+static auto externalName(const linker * pNode) -> std::string
+{
+  const linker * pName = pNode ? pNode->find(externalKey) : nullptr;
+  if(pName == nullptr || pName->type() != linker::Types::String)
+    return {};
+
+  // Only a plain name, a reference never leads out of the store's directory
+  auto name = pName->value<std::string>();
+  if(name.empty() || name == "." || name == ".." || name.find_first_of("/\\") != std::string::npos)
+    return {};
+
+  return name;
+}
+
+class StoreSettings::Trace
+{
+  StoreStats::Scope    m_timer;
+  StoreObserver *      pObserver;
+  std::string          m_path;
+  StoreObserver::Event m_event;
+
+  static auto timer(StoreObserver::Stage stage) -> StoreStats::Timer
+  {
+    switch(stage)
+    {
+    case StoreObserver::Stage::GetFile:  return StoreStats::Timer::Read;
+    case StoreObserver::Stage::FromJSON: return StoreStats::Timer::Parse;
+    case StoreObserver::Stage::ToJSON:   return StoreStats::Timer::Serialize;
+    case StoreObserver::Stage::SetFile:  return StoreStats::Timer::Write;
+    case StoreObserver::Stage::MkDir:    return StoreStats::Timer::MkDir;
+    }
+    return StoreStats::Timer::Read;
+  }
+
+public:
+  Trace(const StoreSettings & store, StoreObserver::Stage stage,
+        const fs::path & file, std::string_view key = {})
+    : m_timer(store.mStats, timer(stage)), pObserver(store.mObserver.get()), m_event{stage, {}, key, 0, {}, {}}
+  {
+    if(this->pObserver)
+    {
+      this->m_path        = file.string();
+      this->m_event.path  = this->m_path;
+      this->m_event.start = std::chrono::steady_clock::now();
+      this->pObserver->onBegin(this->m_event);
+    }
+  }
+  ~Trace()
+  {
+    if(this->pObserver)
+    {
+      this->m_event.duration = std::chrono::steady_clock::now() - this->m_event.start;
+      this->pObserver->onEnd(this->m_event);
+    }
+  }
+
+  Trace(Trace &&) = delete;
+  Trace(const Trace &) = delete;
+  auto operator=(Trace &&) -> Trace & = delete;
+  auto operator=(const Trace &) -> Trace & = delete;
+
+  inline void bytes(std::size_t count)
+  {
+    this->m_event.bytes = count;
+  }
+};
+
+//--------------------------------------------------------------------------------------------------
 StoreSettings::StoreSettings(const std::string & path, DirectoryPath dir)
-  : mPath(setup_path(path)), mDirType(dir), mDir(setup_dir(path, this->dir()))
+  : mPath(setup_path(path)), mDirType(dir), mDir(setup_dir(path, this->dir())),
+    mFile(this->mDir.path() / this->mPath), mDirReady(this->mDir.exists()),
+    mShared(share(this->mFile))
 {
   // Empty
 }
 
 StoreSettings::StoreSettings(const std::string & path, const fs::path & dir)
-    : mPath(setup_path(path)), mDirType(std::nullopt), mDir(setup_dir(path, dir))
+    : mPath(setup_path(path)), mDirType(std::nullopt), mDir(setup_dir(path, dir)),
+      mFile(this->mDir.path() / this->mPath), mDirReady(this->mDir.exists()),
+      mShared(share(this->mFile))
 {
   // Empty
 }
 
+// Parsed files of one store, shared by every handle whose main file resolves to the same path.
+// Documents are keyed by file name, a main file and its shards always live in one directory
+struct StoreSettings::Shared
+{
+  std::recursive_mutex         lock;
+  std::map<fs::path, Document> documents;
+  // Moves on whenever documents changes
+  std::uint64_t                generation = Shared::tick();
+
+  // Values are never reused across stores, and start above the 0 of an unresolved Slot
+  static auto tick() -> std::uint64_t
+  {
+    static std::atomic<std::uint64_t> counter = 0;
+    return ++counter;
+  }
+};
+
+auto StoreSettings::share(const fs::path & file) -> std::shared_ptr<Shared>
+{
+  static std::mutex                                lock;
+  static std::map<fs::path, std::weak_ptr<Shared>> registry;
+
+  // Symlinks, "." and ".." resolve to one key, as far as the path exists yet
+  std::error_code error;
+  fs::path        key = fs::weakly_canonical(file, error);
+  if(error) key = fs::absolute(file, error).lexically_normal();
+
+  std::lock_guard guard { lock };
+  std::erase_if(registry, [](const auto & entry) { return entry.second.expired(); });
+
+  auto & entry = registry[key];
+  auto   ret   = entry.lock();
+  if(!ret)
+  {
+    ret   = std::make_shared<Shared>();
+    entry = ret;
+  }
+  return ret;
+}
+
 //--------------------------------------------------------------------------------------------------
 auto StoreSettings::getObject(const std::string & key) const -> linker
 {
-  linkerFile file = this->getFile();
+  return this->getObject(linkerPath::key(key));
+}
+
+auto StoreSettings::setObject(const std::string & key, linker value) const -> StoreSettings::State
+{
+  return this->setObject(linkerPath::key(key), std::move(value));
+}
+
+auto StoreSettings::getObject(const linkerPath & path, Slot * pSlot) const -> linker
+{
+  this->mStats.add(StoreStats::Counter::Gets);
 
-  if(file.isJSONObject())
+  // The published document answers for the whole store, files are only read until it exists
+  if(this->mShm && this->mShm->mode() == StoreShm::Mode::Reader)
   {
-    auto sett = file.getJSONObject();
-    return sett[key];
+    if(auto value = this->mShm->get(path))
+      return value->type() != linker::Types::Other ? std::move(*value) : this->defaultValue(path);
   }
-  return {};
+
+  std::lock_guard guard { this->mShared->lock };
+
+  const bool       resolved = pSlot != nullptr && pSlot->generation == this->mShared->generation;
+  const fs::path & file     = resolved     ? *pSlot->pFile
+                            : path.empty() ? this->mFile : this->storeFile(path.front());
+
+  std::optional<Document> loaded;
+  const Document *        pCached = this->cached(file, resolved ? pSlot->pDocument : nullptr);
+
+  // A miss parses the whole file once (or remembers it as absent), the slot and later gets
+  // are served from the kept document
+  if(pCached == nullptr)
+  {
+    const std::string key = path.size() == 1 ? path.front() : path.toPointer();
+    linkerFile        lfSett = this->getFile(file, key);
+
+    if(auto it = this->mShared->documents.find(file.filename()); it != this->mShared->documents.end())
+    {
+      pCached = &it->second;
+    }
+    else
+    {
+      // Changed on disk while it was read, so nothing was kept: answered from this parse alone
+      loaded.emplace(Document { std::move(lfSett) });
+      loaded->external = true;
+
+      pCached = &*loaded;
+      pSlot   = nullptr;
+    }
+  }
+
+  if(pSlot == nullptr)
+  {
+    const Document * pSource = this->source(file, pCached, path);
+
+    linker value = pSource ? pSource->file.at(path) : linker();
+    return value.type() != linker::Types::Other ? value : this->defaultValue(path);
+  }
+
+  // cached() moves the generation on when it drops a stale document, getFile() and source()
+  // when they keep one
+  if(pSlot->generation != this->mShared->generation)
+  {
+    const Document * pSource = this->source(file, pCached, path);
+
+    const linker * pValue = pSource ? pSource->file.find(path) : nullptr;
+    if(pValue == nullptr && (pSource == nullptr || pSource->file.at(path).type() == linker::Types::Other))
+      pValue = &this->defaultValue(path);
+
+    *pSlot = { this->mShared->generation, &file, pCached, pSource ? pSource : pCached, pValue };
+  }
+
+  // Elements of packed arrays have no node of their own to point at
+  return pSlot->pValue ? *pSlot->pValue : pSlot->pSource->file.at(path);
 }
 
-auto StoreSettings::setObject(const std::string & key, linker value) const -> StoreSettings::State
+auto StoreSettings::setObject(const linkerPath & path, linker value, bool merge) const
+    -> StoreSettings::State
 {
-  linkerFile file       = this->getFile();
-  linker::object_t sett = file.getJSONObject();
+  this->mStats.add(StoreStats::Counter::Sets);
 
-  sett[key] = std::move(value);
+  // The cached document has to hold what the file will, numbers lose digits when written
+  linkerFile::roundNumbers(value);
 
-  file.setJSONObject(sett);
-  return this->setFile(file);
+  const std::string key  = path.size() == 1 ? path.front() : path.toPointer();
+  const fs::path &  file = path.empty() ? this->mFile : this->storeFile(path.front());
+
+  // Held across the read and the write, a concurrent set on another handle is not lost
+  std::lock_guard guard { this->mShared->lock };
+
+  linkerFile lfSett = this->getFile(file, key);
+  if(!path.empty())
+    this->internalize(lfSett, file, path.front());
+
+  if(const linker * pOld = std::as_const(lfSett).find(path); pOld != nullptr && *pOld == value)
+  {
+    this->mStats.add(StoreStats::Counter::SkippedWrites);
+    return State::OK;
+  }
+
+  // A path the document cannot hold (a key into an array, an index past its end) writes nothing
+  if(auto error = merge ? lfSett.merge(path, std::move(value)) : lfSett.assign(path, std::move(value)))
+    return State::ERROR;
+
+  return this->setFile(std::move(lfSett), file, key);
+}
+
+//--------------------------------------------------------------------------------------------------
+auto StoreSettings::batchFile(Batch & batch, const linkerPath & path) const -> Batch::iterator
+{
+  const fs::path & file = path.empty() ? this->mFile : this->storeFile(path.front());
+
+  auto it = batch.find(file);
+  if(it == batch.end())
+    it = batch.emplace(file, BatchFile { this->getFile(file, {}) }).first;
+
+  return it;
+}
+
+auto StoreSettings::batchFind(Batch & batch, const linkerPath & path) const -> const linker &
+{
+  this->mStats.add(StoreStats::Counter::Gets);
+
+  std::lock_guard guard { this->mShared->lock };
+
+  auto it = this->batchFile(batch, path);
+  auto & entry = it->second;
+
+  // Read through the const overloads, the non-const find() detaches the shared root and unpacks
+  const linkerFile & lfSett = std::as_const(entry.file);
+
+  const linker * pValue = lfSett.find(path);
+
+  // Elements of packed arrays have no node of their own, only they unpack the batch's copy
+  if(pValue == nullptr && lfSett.at(path).type() != linker::Types::Other)
+    pValue = entry.file.find(path);
+
+  const linker * pTop   = path.size() == 1 ? pValue
+                        : (pValue == nullptr && !path.empty()) ? lfSett.find(linkerPath::key(path.front()))
+                        : nullptr;
+
+  // A member kept in a side file is copied into the batch, the cached side document may be dropped
+  if(const std::string name = externalName(pTop); !name.empty())
+  {
+    const linkerPath top   = linkerPath::key(path.front());
+    const Document * pSide = this->sideFile(it->first, name);
+
+    entry.sides.assign(top, pSide ? pSide->file.at(top) : linker());
+    pValue = entry.sides.find(path);
+  }
+
+  return pValue ? *pValue : this->defaultValue(path);
+}
+
+void StoreSettings::batchAssign(Batch & batch, const linkerPath & path, linker value, bool merge) const
+{
+  this->mStats.add(StoreStats::Counter::Sets);
+
+  linkerFile::roundNumbers(value);
+
+  auto   it    = this->batchFile(batch, path);
+  auto & entry = it->second;
+  if(!path.empty())
+    this->internalize(entry.file, it->first, path.front());
+
+  if(const linker * pOld = std::as_const(entry.file).find(path); pOld != nullptr && *pOld == value)
+    return;
+
+  if(auto error = merge ? entry.file.merge(path, std::move(value)) : entry.file.assign(path, std::move(value)))
+  {
+    entry.failed = true;
+    return;
+  }
+
+  entry.dirty = true;
+}
+
+auto StoreSettings::batchStore(Batch & batch) const -> State
+{
+  State ret = State::OK;
+
+  for(auto & [file, entry] : batch)
+  {
+    // The other values of the batch are still written
+    if(entry.failed)
+      ret = State::ERROR;
+
+    if(!entry.dirty)
+    {
+      this->mStats.add(StoreStats::Counter::SkippedWrites);
+      continue;
+    }
+
+    if(this->setFile(std::move(entry.file), file, {}) != State::OK)
+      ret = State::ERROR;
+  }
+  return ret;
 }
 
 //--------------------------------------------------------------------------------------------------
@@ -84,7 +394,7 @@ auto StoreSettings::getArray() const -> linker::array_t
 {
   linkerFile file = this->getFile();
 
-  if(file.isJSONObject())
+  if(file.isJSONArray())
   {
     return file.getJSONArray();
   }
@@ -93,103 +403,239 @@ auto StoreSettings::getArray() const -> linker::array_t
 
 auto StoreSettings::setObject(const linker::array_t & value) const -> StoreSettings::State
 {
+  this->mStats.add(StoreStats::Counter::Sets);
+
+  linker::array_t array = value;
+  for(auto & element : array)
+    linkerFile::roundNumbers(element);
+
   linkerFile file = linkerFile();
 
-  file.setJSONArray(value);
+  file.setJSONArray(array);
   return this->setFile(file);
 }
 
 //--------------------------------------------------------------------------------------------------
-auto StoreSettings::getFile() const -> linkerFile
+auto StoreSettings::getFile(const std::string & key) const -> linkerFile
 {
-  if(this->mkDir() == State::OK)
+  return this->getFile(this->mFile, key);
+}
+
+auto StoreSettings::getFile(const fs::path & file, const std::string & key, State * pState) const
+    -> linkerFile
+{
+  std::lock_guard guard { this->mShared->lock };
+
+  if(const Document * pCached = this->cached(file))
+    return pCached->file;
+
+  // Stamped before the read, a write racing with it only costs another parse later
+  Document document;
+  const bool stamped = stamp(file, document);
+
+  auto content = this->readFile(file, key);
+  if(!content)
   {
-    if(std::ifstream json { this->mainDir().path().string() }; json)
+    if(!stamped)
     {
-      std::string content;
-      while(!json.eof())
-      {
-        std::array<char, 2048> buf = {};
-        json.getline(buf.data(), buf.size());
-        content += buf.data();
-      }
-      json.close();
+      document.missing = true;
+      this->keep(file, std::move(document));
+    }
+    else if(pState != nullptr) *pState = State::ERROR;
+
+    return {};
+  }
+
+  {
+    Trace trace { *this, StoreObserver::Stage::FromJSON, file, key };
+    trace.bytes(content->size());
+
+    // Checked strictly only when asked, a blank file is an empty document as for any get
+    const bool strict = pState != nullptr && content->find_first_not_of(" \t\n\r") != std::string::npos;
 
-      return linkerFile().fromJSON(content);
+    if(!strict) document.file.fromJSON(*content);
+    else if(auto parsed = linkerFile::parse(*content)) document.file = std::move(*parsed);
+    else
+    {
+      *pState = State::ERROR;
+      document.file.fromJSON(*content);
     }
   }
+  document.external = content->find(externalTag) != std::string::npos;
 
-  return {};
+  if(!stamped)
+    return std::move(document.file);
+
+  return this->keep(file, std::move(document)).file;
 }
 
-auto StoreSettings::setFile(linkerFile lfSett) const -> StoreSettings::State
+auto StoreSettings::cached(const fs::path & file, const Document * pDocument) const
+    -> const Document *
 {
-  if(this->mkDir() == State::OK)
+  if(pDocument == nullptr)
   {
-    if(std::ofstream json { this->mainDir().path() }; json)
-    {
-      std::string content = lfSett.toJSON(false);
-      json.write(content.c_str(), (std::streamsize)content.length());
-      json.close();
+    auto it = this->mShared->documents.find(file.filename());
+    if(it == this->mShared->documents.end())
+      return nullptr;
 
-      return State::OK;
-    }
+    pDocument = &it->second;
   }
-  return State::ERROR;
+
+  Document   current;
+  const bool present = stamp(file, current);
+
+  if(present == pDocument->missing
+  || (present && (current.time != pDocument->time || current.size != pDocument->size)))
+  {
+    this->drop(file);
+    return nullptr;
+  }
+
+  this->mStats.add(StoreStats::Counter::CacheHits);
+  return pDocument;
 }
 
-auto StoreSettings::mkDir() const -> StoreSettings::State
+auto StoreSettings::keep(const fs::path & file, Document && document) const -> const Document &
+{
+  this->mShared->generation = Shared::tick();
+  auto & documents = this->mShared->documents;
+  return documents.insert_or_assign(file.filename(), std::move(document)).first->second;
+}
+
+void StoreSettings::drop(const fs::path & file) const
 {
-  std::size_t index = 0;
-  std::string sDir = this->mDir.path().string();
+  std::lock_guard guard { this->mShared->lock };
+
+  if(this->mShared->documents.erase(file.filename()))
+    this->mShared->generation = Shared::tick();
+}
 
-  if(!this->mDir.exists())
+auto StoreSettings::readFile(const fs::path & file, const std::string & key) const
+    -> std::optional<std::string>
+{
+  std::string content;
   {
-    do
-    {
-      index = sDir.find_first_of("\\/", index);
+    Trace trace { *this, StoreObserver::Stage::GetFile, file, key };
 
-      if(index == std::string::npos)
-        break;
+    std::ifstream json { file, std::ios::binary | std::ios::ate };
+    if(!json) return std::nullopt;
 
-      fs::directory_entry sSubDir { fs::path { sDir.substr(0, ++index) } };
-      if(!sSubDir.exists())
-      {
-        fs::create_directory(sSubDir);
-    //    this->mDir.assign(dir);
-      }
+    this->mStats.add(StoreStats::Counter::FileOpens);
 
-      index++;
+    content.resize(std::size_t(std::max<std::streamoff>(json.tellg(), 0)));
+    json.seekg(0);
+    json.read(content.data(), (std::streamsize)content.size());
+    content.resize(std::size_t(json.gcount()));
+    json.close();
 
-    } while(true);
+    trace.bytes(content.size());
+    this->mStats.add(StoreStats::Counter::BytesRead, content.size());
 
-    this->mDir.assign(sDir);
+    if(!StoreCodec::decode(content))
+      return std::nullopt;
   }
 
-//  if(!dir.exists())
-//  {
-//    fs::create_directory(dir);
-////    this->mDir.assign(dir);
-//  }
-  return this->mDir.exists() ? State::OK : State::ERROR;
+  return content;
 }
 
-auto StoreSettings::dir() const -> fs::directory_entry
+auto StoreSettings::setFile(linkerFile lfSett, const std::string & key) const -> StoreSettings::State
+{
+  return this->setFile(std::move(lfSett), this->mFile, key);
+}
+
+auto StoreSettings::setFile(linkerFile lfSett, const fs::path & file, const std::string & key) const
+    -> StoreSettings::State
+{
+  std::lock_guard guard { this->mShared->lock };
+
+  Document document;
+  this->externalize(lfSett, file, document.external);
+  document.file = std::move(lfSett);
+
+  if(this->writeFile(std::move(document), file, key) != State::OK)
+    return State::ERROR;
+
+  this->publish();
+  return State::OK;
+}
+
+auto StoreSettings::writeFile(Document document, const fs::path & file, const std::string & key) const
+    -> StoreSettings::State
 {
-  auto getenv = [&](const std::string & name) -> std::string
+  if(this->mkDir() != State::OK)
+    return State::ERROR;
+
+  Trace trace { *this, StoreObserver::Stage::SetFile, file, key };
+
+  std::ofstream json { file, std::ios::binary };
+  if(!json)
+  {
+    // The directory was verified earlier but may have been removed since
+    this->mDirReady = false;
+
+    if(this->mkDir() == State::OK)
+      json.open(file, std::ios::binary);
+
+    if(!json) return State::ERROR;
+  }
+  this->mStats.add(StoreStats::Counter::FileOpens);
+
+  // Text goes through the codec as it is produced, it is never held whole
+  StoreCodec::Encoder encoder { json, this->mCodec, this->mCodecLevel };
   {
-    if(environ)
+    Trace serialize { *this, StoreObserver::Stage::ToJSON, file, key };
+    std::size_t length = 0;
+
+    document.file.write([&](std::string_view chunk)
     {
-      for(char ** penv = environ; *penv; penv++)
-      {
-        std::string env(*penv);
-        if(env.find(name) != std::string::npos)
-        {
-          return env.substr(env.find('=')+1);
-        }
-      }
-    }
-    return "";
+      length += chunk.size();
+      encoder.write(chunk);
+    });
+    serialize.bytes(length);
+  }
+  const bool written = encoder.finish();
+  json.close();
+
+  trace.bytes(encoder.written());
+  this->mStats.add(StoreStats::Counter::BytesWritten, encoder.written());
+
+  if(!written || !json)
+  {
+    this->drop(file);
+    return State::ERROR;
+  }
+
+  if(stamp(file, document))
+    this->keep(file, std::move(document));
+  else
+    this->drop(file);
+
+  return State::OK;
+}
+
+auto StoreSettings::mkDir() const -> StoreSettings::State
+{
+  if(this->mDirReady)
+    return State::OK;
+
+  Trace trace { *this, StoreObserver::Stage::MkDir, this->mDir.path() };
+  this->mStats.add(StoreStats::Counter::MkDirCalls);
+
+  std::error_code error;
+
+  fs::create_directories(this->mDir.path(), error);
+  this->mDir.refresh(error);
+
+  this->mDirReady = this->mDir.exists();
+  return this->mDirReady ? State::OK : State::ERROR;
+}
+
+auto StoreSettings::dir() const -> fs::directory_entry
+{
+  auto getenv = [](const char * name) -> std::string
+  {
+    const char * value = std::getenv(name);
+    return value ? value : "";
   };
 
   fs::path dirPath;
@@ -230,4 +676,725 @@ auto StoreSettings::dir() const -> fs::directory_entry
 void StoreSettings::setName(const std::string & name)
 {
   this->mPath = setup_path(name);
+  this->mFile = this->mDir.path() / this->mPath;
+  this->mShards.clear();
+  this->mShared = share(this->mFile);
+}
+
+void StoreSettings::setDefaults(std::span<const Default> defaults)
+{
+  linkerFile table;
+
+  for(const auto & entry : defaults)
+  {
+    const linkerPath path = entry.key.starts_with('/') ? linkerPath::pointer(entry.key)
+                                                       : linkerPath::key(std::string(entry.key));
+
+    table.assign(path, std::visit([](const auto & value)
+    {
+      if constexpr (std::is_same_v<std::decay_t<decltype(value)>, std::string_view>)
+        return linker::from(std::string(value));
+      else
+        return linker::from(value);
+    }, entry.value));
+  }
+
+  std::lock_guard guard { this->mShared->lock };
+
+  this->mDefaults           = std::move(table);
+  this->mShared->generation = Shared::tick();
+}
+
+void StoreSettings::setObserver(std::shared_ptr<StoreObserver> observer)
+{
+  this->mObserver = std::move(observer);
+}
+
+auto StoreSettings::setCompression(StoreCodec::Type type, int level) -> State
+{
+  if(!StoreCodec::available(type))
+    return State::ERROR;
+
+  this->mCodec      = type;
+  this->mCodecLevel = level;
+  return State::OK;
+}
+
+void StoreSettings::setSharedMemory(std::shared_ptr<StoreShm> shm)
+{
+  this->mShm = std::move(shm);
+  this->publish();
+}
+
+void StoreSettings::setExternal(std::size_t threshold)
+{
+  this->mExternal = threshold;
+}
+
+void StoreSettings::publish() const
+{
+  if(!this->mShm || this->mShm->mode() != StoreShm::Mode::Writer)
+    return;
+
+  // Readers get the values of side files, not their references
+  if(!this->mShardRule)
+  {
+    (void)this->mShm->publish(this->resolved(this->mFile).at({}));
+    return;
+  }
+
+  // Shards hold disjoint top-level keys, readers see them as one object
+  linker::object_t merged;
+
+  for(const auto & [file, shard] : this->storeFiles())
+  {
+    if(const linkerFile lfSett = this->resolved(file); lfSett.isJSONObject())
+    {
+      for(auto & pair : lfSett.getJSONObject())
+        merged.insert(std::move(pair));
+    }
+  }
+  (void)this->mShm->publish(linker::from(merged));
+}
+
+//--------------------------------------------------------------------------------------------------
+static auto fnv1a(const std::string & str) -> uint64_t
+{
+  uint64_t hash = 14695981039346656037ULL;
+  for(const auto sym : str)
+  {
+    hash ^= (unsigned char)sym;
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+auto StoreSettings::shardByPrefix(char separator) -> ShardRule
+{
+  return [separator](const std::string & key) -> std::string
+  {
+    const std::size_t index = key.find(separator);
+    return index != std::string::npos ? key.substr(0, index) : std::string();
+  };
+}
+
+auto StoreSettings::shardByHash(std::size_t count) -> ShardRule
+{
+  // FNV-1a instead of std::hash, the mapping has to stay stable on disk
+  return [count](const std::string & key) -> std::string
+  {
+    return count > 1 ? std::to_string(fnv1a(key) % count) : std::string();
+  };
+}
+
+void StoreSettings::setSharding(ShardRule rule)
+{
+  std::lock_guard guard { this->mShared->lock };
+
+  this->mShardRule = std::move(rule);
+  this->mShards.clear();
+
+  // Resolved slots point into mShards and at the files of the old rule
+  this->mShared->generation = Shared::tick();
+}
+
+// Shard name as it appears in its file name, distinct shards may share a file
+static auto safeShard(std::string shard) -> std::string
+{
+  for(auto & sym : shard)
+  {
+    if(sym == '/' || sym == '\\' || sym == ':' || (unsigned char)sym < 0x20)
+      sym = '_';
+  }
+  return shard;
+}
+
+auto StoreSettings::shardFile(const std::string & shard) const -> fs::path
+{
+  const std::string name = safeShard(shard);
+
+  return this->mDir.path() / (this->mPath.stem().string() + "." + name
+                            + this->mPath.extension().string());
+}
+
+auto StoreSettings::storeFile(const std::string & key) const -> const fs::path &
+{
+  if(!this->mShardRule)
+    return this->mFile;
+
+  std::string shard = this->mShardRule(key);
+  if(shard.empty())
+    return this->mFile;
+
+  auto it = this->mShards.find(shard);
+  if(it == this->mShards.end())
+  {
+    fs::path file = this->shardFile(shard);
+    it = this->mShards.emplace(std::move(shard), std::move(file)).first;
+  }
+  return it->second;
+}
+
+auto StoreSettings::storeFiles() const -> std::vector<std::pair<fs::path, std::string>>
+{
+  std::vector<std::pair<fs::path, std::string>> ret { { this->mFile, {} } };
+
+  if(!this->mShardRule)
+    return ret;
+
+  const std::string prefix = this->mPath.stem().string() + ".";
+  const std::string suffix = this->mPath.extension().string();
+  std::error_code   error;
+
+  for(const auto & entry : fs::directory_iterator(this->mDir.path(), error))
+  {
+    const std::string name = entry.path().filename().string();
+
+    if(name.size() <= prefix.size() + suffix.size() || name.compare(0, prefix.size(), prefix)
+    || name.compare(name.size() - suffix.size(), suffix.size(), suffix))
+      continue;
+
+    // Unrelated files sharing the stem are filtered out again by keys() through the rule
+    std::string shard = name.substr(prefix.size(), name.size() - prefix.size() - suffix.size());
+    if(this->shardFile(shard) == entry.path())
+      ret.emplace_back(entry.path(), std::move(shard));
+  }
+
+  return ret;
+}
+
+auto StoreSettings::keys() const -> std::vector<std::string>
+{
+  std::vector<std::string> ret;
+
+  for(const auto & entry : this->entries())
+    ret.push_back(entry.key());
+
+  return ret;
+}
+
+auto StoreSettings::migrate() const -> State
+{
+  if(!this->mShardRule)
+    return State::OK;
+
+  linkerFile                              main = this->getFile();
+  linker::object_t                        rest;
+  std::map<std::string, linker::object_t> moved;
+
+  if(!main.isJSONObject())
+    return State::OK;
+
+  for(auto & pair : main.getJSONObject())
+  {
+    if(std::string shard = this->mShardRule(pair.first); shard.empty())
+      rest.insert(pair);
+    else
+      moved[shard].insert(pair);
+  }
+  if(moved.empty())
+    return State::OK;
+
+  // Shards are written before the main file is trimmed, an interrupted
+  // migration leaves duplicates rather than losing keys
+  for(auto & [shard, values] : moved)
+  {
+    const fs::path & path = this->storeFile(values.begin()->first);
+
+    linkerFile       file = this->getFile(path, {});
+    linker::object_t sett = file.getJSONObject();
+
+    for(auto & pair : values)
+      sett[pair.first] = std::move(pair.second);
+
+    file.setJSONObject(sett);
+    if(this->setFile(file, path, {}) != State::OK)
+      return State::ERROR;
+  }
+
+  main.setJSONObject(rest);
+  return this->setFile(main);
+}
+
+auto StoreSettings::scan(linkerReader::Visitor & visitor) const -> State
+{
+  std::string buffer(linkerReader::chunk, '\0');
+
+  for(const auto & [file, shard] : this->storeFiles())
+  {
+    Trace trace { *this, StoreObserver::Stage::GetFile, file, shard };
+
+    std::ifstream json { file, std::ios::binary };
+    if(!json) continue;
+
+    this->mStats.add(StoreStats::Counter::FileOpens);
+
+    linkerReader                       reader { visitor };
+    std::optional<StoreCodec::Decoder> decoder;
+    std::size_t                        bytes = 0;
+    bool                               going = true;
+
+    const StoreCodec::Decoder::Sink sink = [&reader, &going](std::string_view text)
+    {
+      going = going && reader.feed(text);
+    };
+
+    while(going && (json.read(buffer.data(), (std::streamsize)buffer.size()) || json.gcount() > 0))
+    {
+      const std::string_view data { buffer.data(), std::size_t(json.gcount()) };
+      bytes += data.size();
+
+      if(!decoder) decoder.emplace(StoreCodec::detect(data));
+      if(!decoder->write(data, sink)) break;
+    }
+
+    trace.bytes(bytes);
+    this->mStats.add(StoreStats::Counter::BytesRead, bytes);
+
+    // An empty file is an empty document, as for a get
+    if(bytes == 0)
+      continue;
+
+    if(reader.stopped())
+      return State::OK;
+    if(!decoder || !decoder->finish() || reader.finish())
+      return State::ERROR;
+  }
+
+  return State::OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+auto StoreSettings::entries(std::string_view prefix) const -> Range
+{
+  Range range;
+  range.pStore   = this;
+  range.m_prefix = prefix;
+
+  for(auto & [file, shard] : this->storeFiles())
+  {
+    // The copy holds the nodes, iterators into its members stay valid wherever it is moved
+    linkerFile lfSett = this->getFile(file, {});
+
+    const linker::object_t * pMembers = lfSett.members();
+    if(pMembers == nullptr)
+      continue;
+
+    const auto begin = pMembers->lower_bound(prefix);
+    range.m_cursors.push_back({ std::move(lfSett), std::move(file), std::move(shard), begin, pMembers->end() });
+  }
+
+  return range;
+}
+
+auto StoreSettings::Range::begin() const -> iterator
+{
+  return iterator { this };
+}
+
+StoreSettings::Range::iterator::iterator(const Range * pRange) : pRange(pRange)
+{
+  this->m_at.reserve(pRange->m_cursors.size());
+  for(const auto & cursor : pRange->m_cursors)
+    this->m_at.push_back(cursor.begin);
+
+  this->settle();
+}
+
+// Moves every cursor to its next member in range, the smallest key among them becomes current
+void StoreSettings::Range::iterator::settle()
+{
+  const auto & rule = this->pRange->pStore->mShardRule;
+
+  this->m_current = std::string::npos;
+
+  for(std::size_t i = 0; i < this->m_at.size(); i++)
+  {
+    const Cursor & cursor = this->pRange->m_cursors[i];
+    auto &         at     = this->m_at[i];
+
+    for(; at != cursor.end; ++at)
+    {
+      // Keys are sorted, the first one without the prefix ends this cursor
+      if(!std::string_view(at->first.str()).starts_with(this->pRange->m_prefix))
+      {
+        at = cursor.end;
+        break;
+      }
+      // A key left behind in the wrong file (an interrupted migration) is read from its shard.
+      // cursor.shard comes from the file name, so the rule's name is compared the way it is written
+      if(!rule || safeShard(rule(at->first)) == cursor.shard)
+        break;
+    }
+
+    if(at != cursor.end
+    && (this->m_current == std::string::npos || at->first < this->m_at[this->m_current]->first))
+      this->m_current = i;
+  }
+
+  if(this->m_current == std::string::npos)
+  {
+    this->m_entry = {};
+    return;
+  }
+
+  const auto & at = this->m_at[this->m_current];
+  this->m_entry.pStore = this->pRange->pStore;
+  this->m_entry.pFile  = &this->pRange->m_cursors[this->m_current].path;
+  this->m_entry.pKey   = &at->first;
+  this->m_entry.pValue = &at->second;
+}
+
+auto StoreSettings::Range::iterator::operator++() -> iterator &
+{
+  ++this->m_at[this->m_current];
+  this->settle();
+  return *this;
+}
+
+auto StoreSettings::Range::iterator::operator==(const iterator & other) const -> bool
+{
+  return this->m_current == other.m_current
+      && (this->m_current == std::string::npos || this->m_entry.pValue == other.m_entry.pValue);
+}
+
+auto StoreSettings::Entry::node() const -> linker
+{
+  const std::string name = externalName(this->pValue);
+  if(name.empty())
+    return *this->pValue;
+
+  const Document * pSide = this->pStore->sideFile(*this->pFile, name);
+  return pSide ? pSide->file.at(linkerPath::key(this->key())) : linker();
+}
+
+//--------------------------------------------------------------------------------------------------
+// Hidden and named after its store file, shard listings never take it for a shard
+static auto sideName(const fs::path & file, const std::string & key) -> std::string
+{
+  char hash[17];
+  std::snprintf(hash, sizeof(hash), "%016llx", (unsigned long long)fnv1a(key));
+
+  return "." + file.filename().string() + "." + hash;
+}
+
+void StoreSettings::externalize(linkerFile & lfSett, const fs::path & file, bool & external) const
+{
+  // Copied first, writing the side files does not touch the cached main document
+  const auto       it     = this->mShared->documents.find(file.filename());
+  const linkerFile before = (it != this->mShared->documents.end() && it->second.external)
+                          ? it->second.file : linkerFile();
+
+  external = false;
+  if(!lfSett.isJSONObject() || (this->mExternal == 0 && before.isEmpty()))
+    return;
+
+  linker::object_t members = lfSett.getJSONObject();
+  bool             changed = false;
+
+  for(auto & [key, value] : members)
+  {
+    // References are kept as they are, their side files only change when the value does
+    if(!externalName(&value).empty())
+    {
+      external = true;
+      continue;
+    }
+    if(this->mExternal == 0 || linkerFile::textSize(value, this->mExternal) < this->mExternal)
+      continue;
+
+    const std::string name = sideName(file, key);
+
+    Document side;
+    side.file.setJSONObject({ { key, value } });
+
+    // A side file that cannot be written leaves the value inline
+    if(this->writeFile(std::move(side), file.parent_path() / name, key) != State::OK)
+      continue;
+
+    value    = linker::from(linker::object_t { { externalKey, linker::from(name) } });
+    external = changed = true;
+  }
+
+  // Members moved to another file (a shard) take their reference along, the side file stays
+  if(before.isJSONObject())
+  {
+    for(const auto & [key, value] : before.getJSONObject())
+    {
+      const std::string name = externalName(&value);
+      auto              now  = members.find(key);
+
+      if(name.empty() || now == members.end() || externalName(&now->second) == name)
+        continue;
+
+      std::error_code error;
+      fs::remove(file.parent_path() / name, error);
+      this->drop(file.parent_path() / name);
+    }
+  }
+
+  if(changed)
+    lfSett.setJSONObject(members);
+}
+
+auto StoreSettings::sideFile(const fs::path & file, const std::string & name) const -> const Document *
+{
+  std::lock_guard guard { this->mShared->lock };
+
+  const fs::path side = file.parent_path() / name;
+  if(const Document * pCached = this->cached(side))
+    return pCached;
+
+  // Stamped before the read, as in getFile()
+  Document document;
+  if(!stamp(side, document))
+    return nullptr;
+
+#if STORE_SETTINGS_POSIX
+  // Parsed straight from the page cache, only a compressed file is copied (to be inflated)
+  const int fd = ::open(side.c_str(), O_RDONLY | O_CLOEXEC);
+  if(fd < 0) return nullptr;
+
+  this->mStats.add(StoreStats::Counter::FileOpens);
+
+  struct stat       info {};
+  const std::size_t size  = ::fstat(fd, &info) == 0 ? std::size_t(info.st_size) : 0;
+  void *            pView = size > 0 ? ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+  ::close(fd);
+
+  if(pView == MAP_FAILED) return nullptr;
+
+  std::string_view text { static_cast<const char *>(pView), size };
+  std::string      inflated;
+  bool             valid = true;
+  {
+    Trace trace { *this, StoreObserver::Stage::GetFile, side, name };
+    trace.bytes(size);
+    this->mStats.add(StoreStats::Counter::BytesRead, size);
+
+    if(StoreCodec::detect(text) != StoreCodec::Type::None)
+    {
+      inflated.assign(text);
+      valid = StoreCodec::decode(inflated);
+      text  = inflated;
+    }
+  }
+
+  if(valid)
+  {
+    Trace trace { *this, StoreObserver::Stage::FromJSON, side, name };
+    trace.bytes(text.size());
+
+    document.file.fromJSON(text);
+  }
+  ::munmap(pView, size);
+
+  if(!valid) return nullptr;
+#else
+  auto content = this->readFile(side, name);
+  if(!content) return nullptr;
+
+  {
+    Trace trace { *this, StoreObserver::Stage::FromJSON, side, name };
+    trace.bytes(content->size());
+
+    document.file.fromJSON(*content);
+  }
+#endif
+
+  return &this->keep(side, std::move(document));
+}
+
+auto StoreSettings::source(const fs::path & file, const Document * pDocument,
+                           const linkerPath & path) const -> const Document *
+{
+  if(path.empty() || !pDocument->external)
+    return pDocument;
+
+  const std::string name = externalName(pDocument->file.find(linkerPath::key(path.front())));
+  return name.empty() ? pDocument : this->sideFile(file, name);
+}
+
+auto StoreSettings::resolved(const fs::path & file) const -> linkerFile
+{
+  std::lock_guard guard { this->mShared->lock };
+
+  linkerFile lfSett = this->getFile(file, {});
+
+  const auto it = this->mShared->documents.find(file.filename());
+  if(it == this->mShared->documents.end() || !it->second.external || !lfSett.isJSONObject())
+    return lfSett;
+
+  linker::object_t members = lfSett.getJSONObject();
+  for(auto & [key, value] : members)
+  {
+    if(const std::string name = externalName(&value); !name.empty())
+    {
+      const Document * pSide = this->sideFile(file, name);
+      value = pSide ? pSide->file.at(linkerPath::key(key)) : linker();
+    }
+  }
+
+  lfSett.setJSONObject(members);
+  return lfSett;
+}
+
+void StoreSettings::internalize(linkerFile & lfSett, const fs::path & file, const std::string & key) const
+{
+  const linkerPath  top  = linkerPath::key(key);
+  const std::string name = externalName(std::as_const(lfSett).find(top));
+  if(name.empty())
+    return;
+
+  // An unreadable side file leaves nothing to merge into
+  const Document * pSide = this->sideFile(file, name);
+  lfSett.assign(top, pSide ? pSide->file.at(top) : linker());
+}
+
+//--------------------------------------------------------------------------------------------------
+auto StoreSettings::load() const -> State
+{
+  State ret = State::OK;
+
+  for(const auto & [file, shard] : this->storeFiles())
+    (void)this->getFile(file, {}, &ret);
+
+  return ret;
+}
+
+auto StoreSettings::preload(std::span<StoreSettings * const> stores, std::size_t threads) -> State
+{
+  // Largest first, the slowest file starts at once and the small ones fill in around it
+  std::vector<std::pair<std::uintmax_t, StoreSettings *>> queue;
+  queue.reserve(stores.size());
+
+  for(auto * pStore : stores)
+  {
+    if(pStore == nullptr) continue;
+
+    std::error_code error;
+    const auto size = fs::file_size(pStore->mFile, error);
+    queue.emplace_back(error ? 0 : size, pStore);
+  }
+
+  // A store listed twice would be loaded by two threads at once
+  std::sort(queue.begin(), queue.end(), std::greater<>());
+  queue.erase(std::unique(queue.begin(), queue.end()), queue.end());
+
+  if(threads == 0)
+    threads = std::max(1U, std::thread::hardware_concurrency());
+  threads = std::min(threads, queue.size());
+
+  std::atomic<std::size_t> next   = 0;
+  std::atomic<bool>        failed = false;
+
+  auto work = [&]
+  {
+    for(std::size_t i = next++; i < queue.size(); i = next++)
+    {
+      try
+      {
+        if(queue[i].second->load() != State::OK)
+          failed = true;
+      }
+      catch(...)
+      {
+        failed = true;
+      }
+    }
+  };
+
+  {
+    std::vector<std::jthread> pool;
+    for(std::size_t i = 1; i < threads; i++)
+      pool.emplace_back(work);
+
+    work();
+  }
+
+  return failed ? State::ERROR : State::OK;
+}
+
+//--------------------------------------------------------------------------------------------------
+auto StoreSettings::stamp(const fs::path & file, Document & document) -> bool
+{
+#if STORE_SETTINGS_POSIX
+  // One system call instead of two, every cached get makes it
+  struct stat info {};
+  if(::stat(file.c_str(), &info) != 0 || !S_ISREG(info.st_mode))
+    return false;
+
+  document.time = std::int64_t(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+  document.size = std::uintmax_t(info.st_size);
+  return true;
+#else
+  std::error_code error;
+
+  document.time = fs::last_write_time(file, error).time_since_epoch().count();
+  if(error) return false;
+
+  document.size = fs::file_size(file, error);
+  return !error;
+#endif
+}
+
+auto StoreSettings::defaultValue(const linkerPath & path) const -> const linker &
+{
+  static const linker empty;
+
+  const linker * pValue = this->mDefaults.find(path);
+  return pValue ? *pValue : empty;
+}
+
+auto StoreSettings::snapshot() const -> Version
+{
+  Version version;
+
+  for(const auto & [file, shard] : this->storeFiles())
+  {
+    // A missing file is kept as an empty document, rollback removes it again. Side files are
+    // rewritten by later sets, the version holds their values instead of the references
+    version.mFiles.emplace(file, this->resolved(file));
+  }
+  return version;
+}
+
+auto StoreSettings::rollback(const Version & version) const -> State
+{
+  State ret = State::OK;
+
+  for(const auto & [file, shard] : this->storeFiles())
+  {
+    if(version.mFiles.contains(file))
+      continue;
+
+    std::error_code error;
+    fs::remove(file, error);
+    this->drop(file);
+
+    if(error) ret = State::ERROR;
+  }
+
+  for(const auto & [file, lfSett] : version.mFiles)
+  {
+    if(this->resolved(file) == lfSett)
+    {
+      this->mStats.add(StoreStats::Counter::SkippedWrites);
+      continue;
+    }
+
+    if(lfSett.isEmpty())
+    {
+      std::error_code error;
+      fs::remove(file, error);
+      this->drop(file);
+
+      if(error) ret = State::ERROR;
+    }
+    else if(this->setFile(lfSett, file, {}) != State::OK)
+      ret = State::ERROR;
+  }
+
+  this->publish();
+  return ret;
 }
@@ -1,18 +1,31 @@
 #pragma once
 
 #include <filesystem>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <span>
+#include <string_view>
 #include <type_traits>
+#include <variant>
 
 #include "linker.hpp"
+#include "linker_file.hpp"
+#include "linker_path.hpp"
+#include "linker_reader.hpp"
 #include "serializer.hpp"
+#include "store_codec.hpp"
+#include "store_observer.hpp"
+#include "store_shm.hpp"
+#include "store_stats.hpp"
 
 namespace fs = std::filesystem;
 
-class linkerFile;
-
 class StoreSettings
 {
   bool deleted = false;
+  struct Document;
 public:
   enum class State : uint8_t
   {
@@ -26,6 +39,42 @@ public:
     Temp
   };
 
+  // Maps a key to the shard holding it, an empty name means the main file
+  using ShardRule = std::function<std::string(const std::string & key)>;
+
+  static auto shardByPrefix(char separator = '.') -> ShardRule;
+  static auto shardByHash(std::size_t count)      -> ShardRule;
+
+  // Value a key has while the store holds none, meant for a constexpr table next to the Settings:
+  //   static constexpr StoreSettings::Default defaults[] { { "width", 800 }, { "/net/proxy", "" } };
+  // Keys starting with '/' are JSON pointers into nested objects
+  struct Default
+  {
+    using value_t = std::variant<linker::null_t, linker::bool_t, linker::number_t, std::string_view>;
+
+    std::string_view key;
+    value_t          value;
+
+    constexpr Default(std::string_view key, linker::null_t) : key(key), value(nullptr)
+    {
+      // Empty
+    }
+    constexpr Default(std::string_view key, linker::bool_t value) : key(key), value(value)
+    {
+      // Empty
+    }
+    template<typename T>
+      requires (std::is_arithmetic_v<T> && !std::is_same_v<T, bool>)
+    constexpr Default(std::string_view key, T value) : key(key), value(linker::number_t(value))
+    {
+      // Empty
+    }
+    constexpr Default(std::string_view key, const char * value) : key(key), value(std::string_view(value))
+    {
+      // Empty
+    }
+  };
+
   StoreSettings(const std::string & path, DirectoryPath = DirectoryPath::User);
   StoreSettings(const std::string & path, const fs::path & dir);
   ~StoreSettings() = default;
@@ -40,16 +89,91 @@ public:
     return this->mPath.string();
   }
   void setName(const std::string & name);
+  // Replaces the defaults table. Gets of keys the store lacks are answered from it, and a missing
+  // file is remembered so they cost a single stat; the file is only created by the first write
+  void setDefaults(std::span<const Default> defaults);
+
+  // Counts what this handle did. Documents are shared by every handle on the path, so a file
+  // parsed for one handle shows as a FileOpen there and as CacheHits on the others
+  [[nodiscard]] inline auto stats() const -> StoreStats::Snapshot
+  {
+    return this->mStats.snapshot();
+  }
+  void setObserver(std::shared_ptr<StoreObserver> observer);
+
+  // Codec used by later writes, reads detect it from the file; ERROR when it was not built in
+  auto setCompression(StoreCodec::Type type, int level = 1) -> State;
+
+  // A Writer segment receives the whole store now and after every write (shards merged into one
+  // object). With a Reader segment gets are answered from it, without system calls or parsing,
+  // once something was published; sets still go to the files
+  void setSharedMemory(std::shared_ptr<StoreShm> shm);
+
+  // Top-level values whose text reaches threshold bytes (0 keeps everything inline) are written
+  // to a side file next to their store file, the document holds {"$external": "<side file>"}
+  // in their place. A side file is mapped and parsed only when its key is read, and rewritten
+  // only when its value changes. getFile() and scan() see the reference objects
+  void setExternal(std::size_t threshold);
+
+  void setSharding(ShardRule rule);
+  [[nodiscard]] inline auto isSharded() const -> bool
+  {
+    return static_cast<bool>(this->mShardRule);
+  }
+  [[nodiscard]] auto keys()    const -> std::vector<std::string>;
+  [[nodiscard]] auto migrate() const -> State;
+
+  // Reads and parses every store on a pool of threads (hardware concurrency when 0),
+  // later gets are served from memory. A store must not be used elsewhere meanwhile.
+  // ERROR when a file exists but cannot be read or is not valid JSON
+  static auto preload(std::span<StoreSettings * const> stores, std::size_t threads = 0) -> State;
+
+  // Streams every store file (the main one, then each shard) through visitor a chunk at a time,
+  // nothing is parsed into documents or cached. Each file is one top-level value; a visitor
+  // stopping the scan ends it with OK, a malformed or corrupt file with ERROR
+  auto scan(linkerReader::Visitor & visitor) const -> State;
+
+  // Point-in-time copy of every store file, shares its nodes with the live documents
+  class Version
+  {
+    std::map<fs::path, linkerFile> mFiles;
+
+    friend class StoreSettings;
+  };
+
+  // O(1) per file once loaded (a file with side files costs a pass over its top-level members),
+  // later writes copy only the nodes on the paths they change
+  [[nodiscard]] auto snapshot() const -> Version;
+  // Files equal to the version are left alone, files created since are removed
+  auto rollback(const Version & version) const -> State;
 
 protected:
+  // Where a Setting was last found, trusted while the store's generation is unchanged
+  struct Slot
+  {
+    std::uint64_t    generation = 0;
+    const fs::path * pFile      = nullptr;
+    const Document * pDocument  = nullptr;
+    // Side file the value was read from, otherwise pDocument
+    const Document * pSource    = nullptr;
+    const linker *   pValue     = nullptr;
+  };
+
   template <typename Type>
   class Setting
   {
     StoreSettings * pStore;
-    std::string     m_key;
+    linkerPath      m_path;
+    mutable Slot    m_slot;
 
   public:
-    Setting(StoreSettings * const pStore, std::string key) : pStore(pStore), m_key(std::move(key))
+    Setting(StoreSettings * const pStore, std::string key)
+      : pStore(pStore), m_path(linkerPath::key(std::move(key)))
+    {
+      // Empty
+    }
+    // Nested leaf, e.g. linkerPath::pointer("/network/http/timeout")
+    Setting(StoreSettings * const pStore, linkerPath path) : pStore(pStore), m_path(std::move(path))
     {
       // Empty
     }
@@ -63,39 +187,292 @@ protected:
     auto operator=(Setting && other) noexcept -> Setting & = default;
     auto operator=(const Setting & other)     -> Setting & = default;
 
+    // Repeated gets of an unchanged document skip the shard rule and the path walk
     auto get() const -> Type
+    {
+      return Setting::convert(this->pStore->getObject(this->m_path, &this->m_slot));
+    }
+    // Reuses the storage already held by out (vector capacity, strings, nested members)
+    auto get(Type & out) const -> Type &
+    {
+      return Setting::convert(this->pStore->getObject(this->m_path, &this->m_slot), out);
+    }
+    // Checked get: MissingKey when the store has no value, TypeMismatch when it holds another type
+    auto tryGet() const -> linker::expected_t<Type>
+    {
+      auto ret = this->pStore->getObject(this->m_path, &this->m_slot).template get<Type>();
+      if(!ret) ret.error().path.insert(0, this->m_path.toPointer());
+
+      return ret;
+    }
+    auto set(const Type value) const -> StoreSettings::State
+    {
+      // Serializer objects only rewrite the fields that changed
+      return this->pStore->setObject(this->m_path, linker::from(value),
+                                     std::is_base_of_v<Serializer, Type>);
+    }
+
+  private:
+    // A temporary node (from getObject) is consumed instead of copied
+    template<class Node>
+    static auto convert(Node && lnk) -> Type
+    {
+      Type object {};
+      Setting::convert(std::forward<Node>(lnk), object);
+      return object;
+    }
+    template<class Node>
+    static auto convert(Node && lnk, Type & out) -> Type &
     {
       if constexpr (std::is_base_of_v<Serializer, Type>)
       {
-        Type object;
+        if(lnk.type() == linker::Types::Object) lnk >> *static_cast<Serializer *>(&out);
+        else                                    out = Type();
 
-        this->pStore->getObject(this->m_key) >> *static_cast<Serializer *>(&object);
-        return object;
+        return out;
       }
-      else return linker::value<Type>(this->pStore->getObject(this->m_key));
+      else return std::forward<Node>(lnk) >> out;
     }
-    auto set(const Type value) const -> StoreSettings::State
+
+    friend class StoreSettings;
+  };
+
+public:
+  // One read of each file involved (a single file unless sharded) for the whole batch
+  template<typename ... Types>
+  [[nodiscard]] auto getMany(const Setting<Types> & ... settings) const -> std::tuple<Types...>
+  {
+    Batch batch;
+    return std::tuple<Types...> { Setting<Types>::convert(this->batchFind(batch, settings.m_path)) ... };
+  }
+
+  // One read and one write of each file involved, e.g. setMany(std::pair { width, 800 }, ...)
+  template<typename ... Types>
+  auto setMany(const std::pair<Setting<Types>, Types> & ... pairs) const -> State
+  {
+    Batch batch;
+    (this->batchAssign(batch, pairs.first.m_path, linker::from(pairs.second),
+                       std::is_base_of_v<Serializer, Types>), ...);
+    return this->batchStore(batch);
+  }
+
+  // Top-level member met by a Range, its value is only converted when asked for
+  class Entry
+  {
+    const StoreSettings * pStore = nullptr;
+    const fs::path *      pFile  = nullptr;
+    const linkerKey *     pKey   = nullptr;
+    const linker *        pValue = nullptr;
+
+    // The value, read from its side file when it has one
+    [[nodiscard]] auto node() const -> linker;
+
+    friend class StoreSettings;
+
+  public:
+    [[nodiscard]] inline auto key() const -> const std::string &
+    {
+      return this->pKey->str();
+    }
+    // Converted like Setting<T>::get()
+    template<class T>
+    [[nodiscard]] auto value() const -> T
+    {
+      return Setting<T>::convert(this->node());
+    }
+    // Checked like Setting<T>::tryGet()
+    template<class T>
+    [[nodiscard]] auto get() const -> linker::expected_t<T>
+    {
+      auto ret = this->node().template get<T>();
+      if(!ret) ret.error().path.insert(0, linkerPath::key(this->key()).toPointer());
+
+      return ret;
+    }
+  };
+
+  // Top-level members in key order, shards merged. Members are visited in place, walking 100 keys
+  // of a large store touches those 100 nodes and copies none of the others. A Range sees the
+  // files as they were when it was made (it shares their nodes like a Version)
+  class Range
+  {
+    struct Cursor
+    {
+      linkerFile                       file;
+      fs::path                         path;
+      std::string                      shard;
+      linker::object_t::const_iterator begin;
+      linker::object_t::const_iterator end;
+    };
+
+    const StoreSettings * pStore = nullptr;
+    std::string           m_prefix;
+    std::vector<Cursor>   m_cursors;
+
+    friend class StoreSettings;
+
+  public:
+    class iterator
+    {
+      const Range *                                 pRange = nullptr;
+      std::vector<linker::object_t::const_iterator> m_at;
+      // Cursor holding the current entry, npos at the end
+      std::size_t                                   m_current = std::string::npos;
+      Entry                                         m_entry;
+
+      explicit iterator(const Range * pRange);
+      void settle();
+
+      friend class Range;
+
+    public:
+      using iterator_category = std::forward_iterator_tag;
+      using value_type        = Entry;
+      using difference_type   = std::ptrdiff_t;
+      using pointer           = const Entry *;
+      using reference         = const Entry &;
+
+      iterator() = default;
+
+      inline auto operator*()  const -> const Entry & { return this->m_entry; }
+      inline auto operator->() const -> const Entry * { return &this->m_entry; }
+
+      auto operator++() -> iterator &;
+      auto operator++(int) -> iterator
+      {
+        iterator ret = *this;
+        ++*this;
+        return ret;
+      }
+      [[nodiscard]] auto operator==(const iterator & other) const -> bool;
+    };
+
+    [[nodiscard]] auto begin() const -> iterator;
+    [[nodiscard]] inline auto end() const -> iterator
     {
-      return this->pStore->setObject(this->m_key, linker::from(value));
+      return {};
     }
   };
 
+  // Members whose key starts with prefix (every member when empty), read from the files
+  [[nodiscard]] auto entries(std::string_view prefix = {}) const -> Range;
+
 private:
   fs::path                     mPath;
   std::optional<DirectoryPath> mDirType;
   mutable fs::directory_entry  mDir;
+  fs::path                     mFile;
+  mutable bool                 mDirReady = false;
+
+  StoreCodec::Type mCodec      = StoreCodec::Type::None;
+  int              mCodecLevel = 1;
+
+  // Built from the Default table, looked up when a get finds nothing
+  linkerFile mDefaults;
+
+  std::shared_ptr<StoreShm> mShm;
+
+  std::size_t mExternal = 0;
+
+  ShardRule                              mShardRule;
+  mutable std::map<std::string, fs::path> mShards;
+
+  // Parsed files, reused while their size and write time are unchanged on disk
+  struct Document
+  {
+    linkerFile         file;
+    std::int64_t       time = 0;
+    std::uintmax_t     size = 0;
+    // Stands for a file absent on disk, valid while it stays absent
+    bool               missing = false;
+    // Some top-level member may be a reference to a side file
+    bool               external = false;
+  };
+  // Documents and their generation, one per store across the process: every handle (a copy or
+  // a separate construction) whose main file resolves to the same path reads and updates them.
+  // Statistics and observers stay with the handle
+  struct Shared;
+  std::shared_ptr<Shared> mShared;
+
+  [[nodiscard]] static auto share(const fs::path & file) -> std::shared_ptr<Shared>;
+
+  [[no_unique_address]] mutable StoreStats mStats;
+  std::shared_ptr<StoreObserver>          mObserver;
+
+  class Trace;
+
+  struct BatchFile
+  {
+    linkerFile file;
+    // Members read from side files, held for the batch like file
+    linkerFile sides {};
+    bool       dirty  = false;
+    // A value was not assigned, its path does not fit the document
+    bool       failed = false;
+  };
+  using Batch = std::map<fs::path, BatchFile>;
+
+  [[nodiscard]] auto batchFile(Batch & batch, const linkerPath & path) const -> Batch::iterator;
+  [[nodiscard]] auto batchFind(Batch & batch, const linkerPath & path) const -> const linker &;
+  void batchAssign(Batch & batch, const linkerPath & path, linker value, bool merge) const;
+  [[nodiscard]] auto batchStore(Batch & batch)                      const -> State;
 
   [[nodiscard]] auto getObject(const std::string & key)               const -> linker;
   [[nodiscard]] auto setObject(const std::string & key, linker value) const -> State;
+  [[nodiscard]] auto getObject(const linkerPath & path,
+                               Slot * pSlot = nullptr)                const -> linker;
+  [[nodiscard]] auto setObject(const linkerPath & path, linker value,
+                               bool merge = false)                    const -> State;
   [[nodiscard]] auto getArray()                                       const -> linker::array_t;
   [[nodiscard]] auto setObject(const linker::array_t & value)         const -> State;
-  [[nodiscard]] auto getFile()                                        const -> linkerFile;
-  [[nodiscard]] auto setFile(linkerFile lfSett)                       const -> State;
+  [[nodiscard]] auto getFile(const std::string & key = {})             const -> linkerFile;
+  // pState, when given, is set to ERROR if file exists but cannot be read or is not valid JSON.
+  // The document is then parsed as leniently as without pState
+  [[nodiscard]] auto getFile(const fs::path & file, const std::string & key,
+                             State * pState = nullptr)                const -> linkerFile;
+  [[nodiscard]] auto readFile(const fs::path & file,
+                              const std::string & key)                const -> std::optional<std::string>;
+  [[nodiscard]] auto setFile(linkerFile lfSett,
+                             const std::string & key = {})            const -> State;
+  [[nodiscard]] auto setFile(linkerFile lfSett, const fs::path & file,
+                             const std::string & key)                 const -> State;
+  // Serializes lfSett to file as it is, setFile() without side files or publishing
+  [[nodiscard]] auto writeFile(Document document, const fs::path & file,
+                               const std::string & key)               const -> State;
+  // Moves large top-level members of lfSett into side files of file, removes the side files
+  // of members that went back inline
+  void externalize(linkerFile & lfSett, const fs::path & file, bool & external) const;
+  // Parsed side file called name next to file, mapped rather than read; nullptr when unreadable
+  [[nodiscard]] auto sideFile(const fs::path & file,
+                              const std::string & name)               const -> const Document *;
+  // Document holding the value at path: pDocument, or the side file of its top-level member
+  [[nodiscard]] auto source(const fs::path & file, const Document * pDocument,
+                            const linkerPath & path)                  const -> const Document *;
+  // Copy of file's document with every reference replaced by the value it stands for
+  [[nodiscard]] auto resolved(const fs::path & file)                  const -> linkerFile;
+  // Puts the referenced value of key back into lfSett before it is changed
+  void internalize(linkerFile & lfSett, const fs::path & file, const std::string & key) const;
+  // Document parsed from file while it is unchanged on disk, pDocument spares the lookup
+  [[nodiscard]] auto cached(const fs::path & file,
+                            const Document * pDocument = nullptr)     const -> const Document *;
+  [[nodiscard]] static auto stamp(const fs::path & file, Document & document) -> bool;
+  // Node of path in mDefaults, an empty node when the table has none
+  [[nodiscard]] auto defaultValue(const linkerPath & path)            const -> const linker &;
+  auto keep(const fs::path & file, Document && document)              const -> const Document &;
+  void drop(const fs::path & file)                                    const;
+  // The main file and every shard file on disk, with the shard name each one holds
+  [[nodiscard]] auto storeFiles() const -> std::vector<std::pair<fs::path, std::string>>;
+  // Parses every file of the store into the cache, ERROR when one of them could not be read
+  [[nodiscard]] auto load()                                           const -> State;
+  [[nodiscard]] auto storeFile(const std::string & key)               const -> const fs::path &;
+  [[nodiscard]] auto shardFile(const std::string & shard)             const -> fs::path;
   [[nodiscard]] auto mkDir()                                          const -> State;
+  // Sends every file to the Writer segment
+  void publish()                                                      const;
 
-  [[nodiscard]] inline auto mainDir() const -> fs::directory_entry
+  [[nodiscard]] inline auto mainDir() const -> const fs::path &
   {
-    return fs::directory_entry(this->mDir.path().string() + this->mPath.string());
+    return this->mFile;
   }
 
   template <typename>
@@ -0,0 +1,481 @@
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+#include "store_shm.hpp"
+
+#if STORE_SETTINGS_SHM
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+// Start of the segment, the document follows at dataOffset
+struct StoreShm::Header
+{
+  std::atomic<std::uint32_t> magic;
+  std::uint32_t              layout;
+  // Odd while the writer copies a document in, 0 before the first one
+  std::atomic<std::uint64_t> sequence;
+  // Bytes the writer has grown the segment to, a reader maps again when its view is smaller
+  std::atomic<std::uint64_t> size;
+  std::atomic<std::uint64_t> used;
+};
+
+struct StoreShm::Node
+{
+  // Bool, or offset of the number, the text or the block of children
+  std::uint64_t value;
+  // Text length or child count
+  std::uint32_t count;
+  std::uint8_t  type;
+  std::uint8_t  pad[3];
+};
+
+struct StoreShm::Member
+{
+  std::uint64_t key;
+  std::uint64_t length;
+  Node          node;
+};
+
+static constexpr std::uint32_t shmMagic   = 0x53544d31;
+// Changes with the node layout or the size of a number, builds that disagree never share data
+static constexpr std::uint32_t shmLayout  = 1u << 16 | sizeof(linker::number_t);
+static constexpr std::size_t   dataOffset = 64;
+// Deeper documents are not read back, a torn copy can never recurse without end
+static constexpr std::size_t   maxDepth   = 1024;
+// A writer that died while copying leaves the sequence odd, readers give up after this many tries
+static constexpr std::size_t   maxRetries = 100000;
+
+static auto reserve(std::vector<char> & out, std::size_t size, std::size_t align) -> std::size_t
+{
+  const std::size_t at = (out.size() + align - 1) / align * align;
+  out.resize(at + size);
+
+  return at;
+}
+
+//--------------------------------------------------------------------------------------------------
+StoreShm::StoreShm(std::string name, Mode mode) : m_name(std::move(name)), m_mode(mode)
+{
+  (void)this->open();
+}
+
+StoreShm::~StoreShm()
+{
+#if STORE_SETTINGS_SHM
+  if(this->pMap != nullptr)
+    ::munmap(this->pMap, this->m_mapped);
+  if(this->m_fd >= 0)
+    ::close(this->m_fd);
+#endif
+}
+
+auto StoreShm::isOpen() const -> bool
+{
+  std::lock_guard lock { this->m_mutex };
+
+  return this->pMap != nullptr;
+}
+
+auto StoreShm::unlink(const std::string & name) -> bool
+{
+#if STORE_SETTINGS_SHM
+  return ::shm_unlink(name.c_str()) == 0;
+#else
+  (void)name;
+  return false;
+#endif
+}
+
+auto StoreShm::header() const -> Header *
+{
+  return reinterpret_cast<Header *>(this->pMap);
+}
+
+auto StoreShm::generation() const -> std::uint64_t
+{
+  std::lock_guard lock { this->m_mutex };
+
+  return this->pMap ? this->header()->sequence.load(std::memory_order_acquire) / 2 : 0;
+}
+
+//--------------------------------------------------------------------------------------------------
+auto StoreShm::open() -> bool
+{
+  if(this->pMap != nullptr)
+    return true;
+
+#if STORE_SETTINGS_SHM
+  const bool writer = this->m_mode == Mode::Writer;
+
+  if(this->m_fd < 0)
+  {
+    this->m_fd = ::shm_open(this->m_name.c_str(), writer ? O_RDWR | O_CREAT : O_RDONLY, 0644);
+    if(this->m_fd < 0) return false;
+  }
+
+  struct stat info {};
+  if(::fstat(this->m_fd, &info) != 0)
+    return false;
+
+  auto size = std::size_t(std::max<off_t>(info.st_size, 0));
+  if(writer && size < dataOffset)
+  {
+    size = std::size_t(::sysconf(_SC_PAGESIZE));
+    if(::ftruncate(this->m_fd, off_t(size)) != 0)
+      return false;
+  }
+
+  // Created by the writer but not set up yet, the next read tries again
+  if(size < dataOffset || !this->map(size))
+    return false;
+
+  Header * pHeader = this->header();
+
+  if(writer)
+  {
+    // A restarted writer goes on from the sequence it left, readers never see it move back
+    if(pHeader->magic.load(std::memory_order_acquire) != shmMagic || pHeader->layout != shmLayout)
+    {
+      pHeader->layout = shmLayout;
+      pHeader->sequence.store(0, std::memory_order_relaxed);
+      pHeader->used.store(0, std::memory_order_relaxed);
+    }
+    pHeader->size.store(size, std::memory_order_relaxed);
+    pHeader->magic.store(shmMagic, std::memory_order_release);
+    return true;
+  }
+
+  if(pHeader->magic.load(std::memory_order_acquire) == shmMagic && pHeader->layout == shmLayout)
+    return true;
+
+  ::munmap(this->pMap, this->m_mapped);
+  this->pMap     = nullptr;
+  this->m_mapped = 0;
+  return false;
+#else
+  return false;
+#endif
+}
+
+auto StoreShm::map(std::size_t size) -> bool
+{
+#if STORE_SETTINGS_SHM
+  const int protection = this->m_mode == Mode::Writer ? PROT_READ | PROT_WRITE : PROT_READ;
+
+  void * pView = ::mmap(nullptr, size, protection, MAP_SHARED, this->m_fd, 0);
+  if(pView == MAP_FAILED)
+    return false;
+
+  if(this->pMap != nullptr)
+    ::munmap(this->pMap, this->m_mapped);
+
+  this->pMap     = static_cast<char *>(pView);
+  this->m_mapped = size;
+  return true;
+#else
+  (void)size;
+  return false;
+#endif
+}
+
+//--------------------------------------------------------------------------------------------------
+auto StoreShm::publish(const linker & root) -> bool
+{
+  std::lock_guard lock { this->m_mutex };
+
+  if(this->m_mode != Mode::Writer || !this->open())
+    return false;
+
+  this->m_buffer.clear();
+  StoreShm::encode(root, this->m_buffer, reserve(this->m_buffer, sizeof(Node), alignof(Node)));
+
+#if STORE_SETTINGS_SHM
+  // The file grows before the header says so, a reader never maps past its end
+  if(const std::size_t need = dataOffset + this->m_buffer.size(); need > this->m_mapped)
+  {
+    const auto        page = std::size_t(::sysconf(_SC_PAGESIZE));
+    const std::size_t size = (std::max(need, this->m_mapped * 2) + page - 1) / page * page;
+
+    if(::ftruncate(this->m_fd, off_t(size)) != 0 || !this->map(size))
+      return false;
+
+    this->header()->size.store(size, std::memory_order_release);
+  }
+#endif
+
+  Header *   pHeader = this->header();
+  const auto begin   = pHeader->sequence.load(std::memory_order_relaxed) | 1;
+
+  pHeader->sequence.store(begin, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  std::memcpy(this->pMap + dataOffset, this->m_buffer.data(), this->m_buffer.size());
+  pHeader->used.store(this->m_buffer.size(), std::memory_order_relaxed);
+
+  pHeader->sequence.store(begin + 1, std::memory_order_release);
+  return true;
+}
+
+auto StoreShm::get(const linkerPath & path) -> std::optional<linker>
+{
+  std::lock_guard lock { this->m_mutex };
+
+  if(!this->open())
+    return std::nullopt;
+
+  for(std::size_t attempt = 0; attempt < maxRetries; attempt++)
+  {
+    const Header * pHeader = this->header();
+    const auto     begin   = pHeader->sequence.load(std::memory_order_acquire);
+
+    if(begin == 0)
+      return std::nullopt;
+
+    if(begin & 1)
+    {
+      std::this_thread::yield();
+      continue;
+    }
+
+    if(const auto size = std::size_t(pHeader->size.load(std::memory_order_acquire)); size > this->m_mapped)
+    {
+      if(!this->map(size)) return std::nullopt;
+      continue;
+    }
+
+    const char *      pData = this->pMap + dataOffset;
+    const std::size_t used  = std::min<std::size_t>(pHeader->used.load(std::memory_order_relaxed),
+                                                     this->m_mapped - dataOffset);
+
+    const std::size_t at    = StoreShm::find(pData, used, path);
+    linker            value = at != std::string::npos ? StoreShm::decode(pData, used, at) : linker();
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if(pHeader->sequence.load(std::memory_order_relaxed) == begin)
+      return value;
+  }
+  return std::nullopt;
+}
+
+//--------------------------------------------------------------------------------------------------
+void StoreShm::encode(const linker & lnk, std::vector<char> & out, std::size_t at)
+{
+  Node node {};
+  node.type = std::uint8_t(lnk.type());
+
+  switch(lnk.type())
+  {
+  case linker::Types::Bool: {
+    node.value = lnk.cast<linker::bool_t>() ? 1 : 0;
+  } break;
+  case linker::Types::Number: {
+    const auto number = lnk.cast<linker::number_t>();
+
+    node.value = reserve(out, sizeof(number), alignof(linker::number_t));
+    std::memcpy(out.data() + node.value, &number, sizeof(number));
+  } break;
+  case linker::Types::String: {
+    const auto & text = lnk.ref<linker::string_t>();
+
+    node.count = std::uint32_t(text.size());
+    node.value = reserve(out, text.size(), 1);
+    std::memcpy(out.data() + node.value, text.data(), text.size());
+  } break;
+  case linker::Types::Array: {
+    // Packed elements become plain number nodes, readers see one kind of array
+    if(const auto * pPacked = lnk.peek<linker::packed_t>())
+    {
+      std::visit([&node, &out](const auto & values)
+      {
+        node.count = std::uint32_t(values.size());
+        node.value = reserve(out, values.size() * sizeof(Node), alignof(Node));
+
+        for(std::size_t i = 0; i < values.size(); i++)
+        {
+          const auto number  = linker::number_t(values[i]);
+          Node       element {};
+
+          element.type  = std::uint8_t(linker::Types::Number);
+          element.value = reserve(out, sizeof(number), alignof(linker::number_t));
+
+          std::memcpy(out.data() + element.value, &number, sizeof(number));
+          std::memcpy(out.data() + node.value + i * sizeof(Node), &element, sizeof(Node));
+        }
+      }, *pPacked);
+      break;
+    }
+
+    const auto & arr = lnk.ref<linker::array_t>();
+
+    node.count = std::uint32_t(arr.size());
+    node.value = reserve(out, arr.size() * sizeof(Node), alignof(Node));
+
+    for(std::size_t i = 0; i < arr.size(); i++)
+      StoreShm::encode(arr[i], out, node.value + i * sizeof(Node));
+  } break;
+  case linker::Types::Object: {
+    // Members come out of the map sorted, as the readers' binary search expects
+    const auto & obj = lnk.ref<linker::object_t>();
+
+    node.count = std::uint32_t(obj.size());
+    node.value = reserve(out, obj.size() * sizeof(Member), alignof(Member));
+
+    std::size_t pos = node.value;
+    for(const auto & [key, value] : obj)
+    {
+      const std::string & name = key.str();
+      Member              member {};
+
+      member.length = name.size();
+      member.key    = reserve(out, name.size(), 1);
+      std::memcpy(out.data() + member.key, name.data(), name.size());
+      std::memcpy(out.data() + pos, &member, offsetof(Member, node));
+
+      StoreShm::encode(value, out, pos + offsetof(Member, node));
+      pos += sizeof(Member);
+    }
+  } break;
+  default: break;
+  }
+
+  std::memcpy(out.data() + at, &node, sizeof(node));
+}
+
+auto StoreShm::find(const char * pData, std::size_t used, const linkerPath & path) -> std::size_t
+{
+  constexpr std::size_t npos = std::string::npos;
+  std::size_t           at   = 0;
+
+  for(const auto & key : path)
+  {
+    if(used < sizeof(Node) || at > used - sizeof(Node))
+      return npos;
+
+    Node node;
+    std::memcpy(&node, pData + at, sizeof(node));
+
+    if(node.value <= at || node.value > used)
+      return npos;
+
+    if(node.type == std::uint8_t(linker::Types::Object))
+    {
+      if(node.count > (used - node.value) / sizeof(Member))
+        return npos;
+
+      std::size_t low  = 0;
+      std::size_t high = node.count;
+      std::size_t next = npos;
+
+      while(low < high && next == npos)
+      {
+        const std::size_t mid = low + (high - low) / 2;
+        const std::size_t pos = node.value + mid * sizeof(Member);
+
+        Member member;
+        std::memcpy(&member, pData + pos, offsetof(Member, node));
+
+        if(member.key > used || member.length > used - member.key)
+          return npos;
+
+        const auto order = std::string_view(pData + member.key, member.length) <=> std::string_view(key);
+
+        if(order == 0)     next = pos + offsetof(Member, node);
+        else if(order < 0) low  = mid + 1;
+        else               high = mid;
+      }
+      if(next == npos)
+        return npos;
+
+      at = next;
+    }
+    else if(node.type == std::uint8_t(linker::Types::Array))
+    {
+      const std::size_t index = linkerPath::index(key);
+
+      if(index >= node.count || node.count > (used - node.value) / sizeof(Node))
+        return npos;
+
+      at = node.value + index * sizeof(Node);
+    }
+    else return npos;
+  }
+
+  return (used >= sizeof(Node) && at <= used - sizeof(Node)) ? at : npos;
+}
+
+auto StoreShm::decode(const char * pData, std::size_t used, std::size_t at, std::size_t depth) -> linker
+{
+  if(depth > maxDepth || used < sizeof(Node) || at > used - sizeof(Node))
+    return {};
+
+  Node node;
+  std::memcpy(&node, pData + at, sizeof(node));
+
+  switch(linker::Types(node.type))
+  {
+  case linker::Types::Null:   return linker() << nullptr;
+  case linker::Types::Bool:   return linker() << (node.value != 0);
+  case linker::Types::Number: {
+    linker::number_t number;
+    if(node.value > used || used - node.value < sizeof(number))
+      return {};
+
+    std::memcpy(&number, pData + node.value, sizeof(number));
+    return linker() << number;
+  }
+  case linker::Types::String: {
+    if(node.value > used || node.count > used - node.value)
+      return {};
+
+    return linker() << std::string(pData + node.value, node.count);
+  }
+  case linker::Types::Array: {
+    if(node.value <= at || node.value > used || node.count > (used - node.value) / sizeof(Node))
+      return {};
+
+    linker::array_t arr;
+    arr.reserve(node.count);
+
+    for(std::size_t i = 0; i < node.count; i++)
+      arr.push_back(StoreShm::decode(pData, used, node.value + i * sizeof(Node), depth + 1));
+
+    linker ret;
+    ret.m_type = linker::Types::Array;
+    ret.store(std::move(arr));
+    return ret;
+  }
+  case linker::Types::Object: {
+    if(node.value <= at || node.value > used || node.count > (used - node.value) / sizeof(Member))
+      return {};
+
+    linker::object_t obj;
+
+    for(std::size_t i = 0; i < node.count; i++)
+    {
+      const std::size_t pos = node.value + i * sizeof(Member);
+
+      Member member;
+      std::memcpy(&member, pData + pos, offsetof(Member, node));
+
+      if(member.key > used || member.length > used - member.key)
+        return {};
+
+      obj.emplace_hint(obj.end(), std::string_view(pData + member.key, member.length),
+                       StoreShm::decode(pData, used, pos + offsetof(Member, node), depth + 1));
+    }
+
+    linker ret;
+    ret.m_type = linker::Types::Object;
+    ret.store(std::move(obj));
+    return ret;
+  }
+  default: return {};
+  }
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "linker.hpp"
+#include "linker_path.hpp"
+
+// POSIX shared memory is used where <sys/mman.h> is found (older glibc needs -lrt),
+// elsewhere a StoreShm never opens
+#if __has_include(<sys/mman.h>) && !defined(_WIN32)
+#  define STORE_SETTINGS_SHM 1
+#else
+#  define STORE_SETTINGS_SHM 0
+#endif
+
+// A document published by one writer process into a named shared memory segment, read by any
+// number of processes in place. The layout is flat: fixed-size nodes, containers point at the
+// block of their children and object members are sorted, so a read walks the path without
+// parsing and copies out only the value found. A sequence counter (odd while the writer copies)
+// guards it: a reader seeing it move during the walk simply walks again.
+// Calls on one instance are serialized, every handle of a store may share it across threads
+class StoreShm
+{
+public:
+  enum class Mode : uint8_t
+  {
+    Reader,
+    Writer
+  };
+
+  // name is a shm_open name, e.g. "/myapp.settings". A writer creates the segment, a reader
+  // opens it and, while nobody has created it yet, tries again on later reads
+  StoreShm(std::string name, Mode mode);
+  ~StoreShm();
+  StoreShm(StoreShm &&) = delete;
+  StoreShm(const StoreShm &) = delete;
+  auto operator=(StoreShm &&) -> StoreShm & = delete;
+  auto operator=(const StoreShm &) -> StoreShm & = delete;
+
+  [[nodiscard]] inline auto mode() const -> Mode
+  {
+    return this->m_mode;
+  }
+  [[nodiscard]] auto isOpen() const -> bool;
+
+  // Writer only, replaces the published document (the first publish grows the segment to fit)
+  auto publish(const linker & root) -> bool;
+  // Copy of the value at path, linker() when the document has none,
+  // nullopt when the segment is missing or nothing was published yet
+  [[nodiscard]] auto get(const linkerPath & path) -> std::optional<linker>;
+  // Publishes so far, 0 before the first one
+  [[nodiscard]] auto generation() const -> std::uint64_t;
+
+  // Removes the segment's name, processes that mapped it keep their view
+  static auto unlink(const std::string & name) -> bool;
+
+private:
+  struct Header;
+  struct Node;
+  struct Member;
+
+  std::string m_name;
+  Mode        m_mode;
+  int         m_fd     = -1;
+  char *      pMap     = nullptr;
+  std::size_t m_mapped = 0;
+  // Held by every public call, open() and map() replace the mapping under it
+  mutable std::mutex m_mutex;
+  // Writer's encoded document, kept to reuse its capacity
+  std::vector<char> m_buffer;
+
+  auto open() -> bool;
+  auto map(std::size_t size) -> bool;
+  [[nodiscard]] auto header() const -> Header *;
+
+  static void encode(const linker & lnk, std::vector<char> & out, std::size_t at);
+  // Reads stay within used and only move forward, a torn copy yields a wrong value
+  // (thrown away by the sequence check) but never a crash. find() gives npos when absent
+  [[nodiscard]] static auto find(const char * pData, std::size_t used, const linkerPath & path)
+    -> std::size_t;
+  [[nodiscard]] static auto decode(const char * pData, std::size_t used, std::size_t at,
+                                   std::size_t depth = 0) -> linker;
+};
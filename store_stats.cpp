@@ -0,0 +1,98 @@
+#include "store_stats.hpp"
+
+auto StoreStats::Histogram::mean() const -> std::chrono::nanoseconds
+{
+  return std::chrono::nanoseconds(this->count ? this->total / this->count : 0);
+}
+
+auto StoreStats::Histogram::percentile(double p) const -> std::chrono::nanoseconds
+{
+  if(!this->count) return {};
+
+  const auto target = uint64_t(double(this->count) * std::clamp(p, 0.0, 1.0));
+  uint64_t   seen   = 0;
+
+  for(std::size_t i = 0; i < buckets; i++)
+  {
+    seen += this->bucket[i];
+    if(seen > target || seen == this->count)
+    {
+      // Upper bound of the bucket, never above the observed maximum
+      return std::chrono::nanoseconds(std::min(i ? (uint64_t(1) << i) - 1 : 0, this->max));
+    }
+  }
+  return std::chrono::nanoseconds(this->max);
+}
+
+//--------------------------------------------------------------------------------------------------
+StoreStats::StoreStats(const StoreStats & other) noexcept
+{
+#if STORE_SETTINGS_STATS
+  this->assign(other.snapshot());
+#else
+  (void)other;
+#endif
+}
+
+auto StoreStats::operator=(const StoreStats & other) noexcept -> StoreStats &
+{
+#if STORE_SETTINGS_STATS
+  if(this != &other) this->assign(other.snapshot());
+#else
+  (void)other;
+#endif
+  return *this;
+}
+
+auto StoreStats::snapshot() const -> Snapshot
+{
+  Snapshot ret;
+
+#if STORE_SETTINGS_STATS
+  for(std::size_t i = 0; i < ret.counters.size(); i++)
+    ret.counters[i] = this->mCounters[i].load(std::memory_order_relaxed);
+
+  for(std::size_t i = 0; i < ret.timers.size(); i++)
+  {
+    const auto & from = this->mTimers[i];
+    auto & to         = ret.timers[i];
+
+    to.count = from.count.load(std::memory_order_relaxed);
+    to.total = from.total.load(std::memory_order_relaxed);
+    to.max   = from.max.load(std::memory_order_relaxed);
+
+    for(std::size_t b = 0; b < buckets; b++)
+      to.bucket[b] = from.bucket[b].load(std::memory_order_relaxed);
+  }
+#endif
+
+  return ret;
+}
+
+void StoreStats::reset()
+{
+#if STORE_SETTINGS_STATS
+  this->assign(Snapshot());
+#endif
+}
+
+#if STORE_SETTINGS_STATS
+void StoreStats::assign(const Snapshot & snapshot)
+{
+  for(std::size_t i = 0; i < snapshot.counters.size(); i++)
+    this->mCounters[i].store(snapshot.counters[i], std::memory_order_relaxed);
+
+  for(std::size_t i = 0; i < snapshot.timers.size(); i++)
+  {
+    const auto & from = snapshot.timers[i];
+    auto & to         = this->mTimers[i];
+
+    to.count.store(from.count, std::memory_order_relaxed);
+    to.total.store(from.total, std::memory_order_relaxed);
+    to.max.store(from.max, std::memory_order_relaxed);
+
+    for(std::size_t b = 0; b < buckets; b++)
+      to.bucket[b].store(from.bucket[b], std::memory_order_relaxed);
+  }
+}
+#endif
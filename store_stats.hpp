@@ -0,0 +1,162 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+
+// Define STORE_SETTINGS_NO_STATS to compile every counter and timer out
+#if defined(STORE_SETTINGS_NO_STATS)
+#  define STORE_SETTINGS_STATS 0
+#else
+#  define STORE_SETTINGS_STATS 1
+#endif
+
+class StoreStats
+{
+public:
+  enum class Counter : uint8_t
+  {
+    FileOpens,
+    BytesRead,
+    BytesWritten,
+    MkDirCalls,
+    Gets,
+    Sets,
+    SkippedWrites,
+    CacheHits,
+    Count
+  };
+
+  enum class Timer : uint8_t
+  {
+    Read,
+    Parse,
+    Serialize,
+    Write,
+    MkDir,
+    Count
+  };
+
+  // Bucket i holds durations in [2^(i-1), 2^i) nanoseconds
+  static constexpr std::size_t buckets = 48;
+
+  struct Histogram
+  {
+    uint64_t count = 0;
+    uint64_t total = 0;
+    uint64_t max   = 0;
+    std::array<uint64_t, buckets> bucket = {};
+
+    [[nodiscard]] auto mean() const -> std::chrono::nanoseconds;
+    [[nodiscard]] auto percentile(double p) const -> std::chrono::nanoseconds;
+  };
+
+  struct Snapshot
+  {
+    std::array<uint64_t, std::size_t(Counter::Count)> counters = {};
+    std::array<Histogram, std::size_t(Timer::Count)>  timers   = {};
+
+    [[nodiscard]] inline auto operator[](Counter counter) const -> uint64_t
+    {
+      return this->counters[std::size_t(counter)];
+    }
+    [[nodiscard]] inline auto operator[](Timer timer) const -> const Histogram &
+    {
+      return this->timers[std::size_t(timer)];
+    }
+  };
+
+  class Scope
+  {
+#if STORE_SETTINGS_STATS
+    StoreStats * pStats;
+    Timer        m_timer;
+    std::chrono::steady_clock::time_point m_start = std::chrono::steady_clock::now();
+#endif
+
+  public:
+    Scope(StoreStats & stats, Timer timer)
+#if STORE_SETTINGS_STATS
+      : pStats(&stats), m_timer(timer)
+#endif
+    {
+      (void)stats; (void)timer;
+    }
+    ~Scope()
+    {
+#if STORE_SETTINGS_STATS
+      this->pStats->record(this->m_timer, std::chrono::steady_clock::now() - this->m_start);
+#endif
+    }
+
+    Scope(Scope &&) = delete;
+    Scope(const Scope &) = delete;
+    auto operator=(Scope &&) -> Scope & = delete;
+    auto operator=(const Scope &) -> Scope & = delete;
+  };
+
+  StoreStats() = default;
+  ~StoreStats() = default;
+  StoreStats(const StoreStats & other) noexcept;
+  StoreStats(StoreStats && other) noexcept : StoreStats(other)
+  {
+    // Empty
+  }
+  auto operator=(const StoreStats & other) noexcept -> StoreStats &;
+  auto operator=(StoreStats && other) noexcept -> StoreStats &
+  {
+    return *this = other;
+  }
+
+  inline void add(Counter counter, uint64_t value = 1)
+  {
+#if STORE_SETTINGS_STATS
+    this->mCounters[std::size_t(counter)].fetch_add(value, std::memory_order_relaxed);
+#else
+    (void)counter; (void)value;
+#endif
+  }
+
+  inline void record(Timer timer, std::chrono::nanoseconds duration)
+  {
+#if STORE_SETTINGS_STATS
+    const auto ns     = uint64_t(duration.count() > 0 ? duration.count() : 0);
+    const auto index  = std::min<std::size_t>(std::bit_width(ns), buckets - 1);
+    auto & histogram  = this->mTimers[std::size_t(timer)];
+
+    histogram.count.fetch_add(1, std::memory_order_relaxed);
+    histogram.total.fetch_add(ns, std::memory_order_relaxed);
+    histogram.bucket[index].fetch_add(1, std::memory_order_relaxed);
+
+    for(auto max = histogram.max.load(std::memory_order_relaxed);
+        ns > max && !histogram.max.compare_exchange_weak(max, ns, std::memory_order_relaxed);)
+    {
+      // Empty
+    }
+#else
+    (void)timer; (void)duration;
+#endif
+  }
+
+  [[nodiscard]] auto snapshot() const -> Snapshot;
+  void reset();
+
+private:
+#if STORE_SETTINGS_STATS
+  struct AtomicHistogram
+  {
+    std::atomic<uint64_t> count = 0;
+    std::atomic<uint64_t> total = 0;
+    std::atomic<uint64_t> max   = 0;
+    std::array<std::atomic<uint64_t>, buckets> bucket = {};
+  };
+
+  std::array<std::atomic<uint64_t>, std::size_t(Counter::Count)> mCounters = {};
+  std::array<AtomicHistogram, std::size_t(Timer::Count)>          mTimers   = {};
+
+  void assign(const Snapshot & snapshot);
+#endif
+};
@@ -0,0 +1,75 @@
+// Values read back in the writing process match what a fresh store reads from the file.
+//   g++ -std=c++20 -I.. ../*.cpp store_roundtrip.cpp -o store_roundtrip -lz -lpthread
+#include <cassert>
+#include <cstdio>
+#include <vector>
+
+#include "store_settings.hpp"
+
+struct Window : Serializer
+{
+  double scale = 0;
+  int    width = 0;
+
+  void configPropertys(PropertyManager & manager) override
+  {
+    manager.add("scale", &this->scale);
+    manager.add("width", &this->width);
+  }
+};
+
+struct Settings : StoreSettings
+{
+  Settings() : StoreSettings("store_roundtrip.json", DirectoryPath::Temp)
+  {
+    // Empty
+  }
+
+  Setting<double>              tiny   { this, "tiny" };
+  Setting<double>              ratio  { this, "ratio" };
+  Setting<std::vector<double>> curve  { this, "curve" };
+  Setting<Window>              window { this, "window" };
+};
+
+int main()
+{
+  const std::vector<double> curve { 0.1, 1e-9, 2.5 };
+
+  Window window;
+  window.scale = 1.0 / 3.0;
+  window.width = 800;
+
+  double tiny  = 0;
+  double ratio = 0;
+  Window shown;
+  {
+    Settings writer;
+    assert(writer.tiny.set(1e-7)                 == StoreSettings::State::OK);
+    assert(writer.ratio.set(0.123456789)         == StoreSettings::State::OK);
+    assert(writer.curve.set(curve)               == StoreSettings::State::OK);
+    assert(writer.window.set(window)             == StoreSettings::State::OK);
+    assert(writer.setMany(std::pair { writer.ratio, 2.0 / 3.0 }) == StoreSettings::State::OK);
+
+    // Read back from the cached document, the same for every handle on the path
+    Settings other;
+    tiny  = writer.tiny.get();
+    ratio = other.ratio.get();
+    shown = writer.window.get();
+
+    assert(other.tiny.get() == tiny);
+  }
+
+  // Every handle is gone, the next one parses the file
+  Settings fresh;
+  assert(fresh.tiny.get()          == tiny);
+  assert(fresh.ratio.get()         == ratio);
+  assert(fresh.window.get().scale  == shown.scale);
+  assert(fresh.window.get().width  == 800);
+  assert(fresh.curve.get()         == curve);
+
+  std::error_code error;
+  fs::remove(fs::temp_directory_path() / "store_roundtrip.json", error);
+
+  std::puts("OK");
+  return 0;
+}
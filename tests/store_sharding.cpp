@@ -0,0 +1,71 @@
+// Setting handles resolved before setSharding() follow the new rule, and keys() lists keys whose
+// shard name is not safe in a file name.
+//   g++ -std=c++20 -I.. ../*.cpp store_sharding.cpp -o store_sharding -lz -lpthread
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+
+#include "store_settings.hpp"
+
+struct Settings : StoreSettings
+{
+  Settings() : StoreSettings("store_sharding.json", DirectoryPath::Temp)
+  {
+    // Empty
+  }
+
+  Setting<int> width   { this, "width" };
+  Setting<int> timeout { this, "http.timeout" };
+  Setting<int> port    { this, "proxy.port" };
+};
+
+static void cleanup()
+{
+  std::error_code error;
+  for(const auto & entry : fs::directory_iterator(fs::temp_directory_path(), error))
+  {
+    if(entry.path().filename().string().starts_with("store_sharding."))
+      fs::remove(entry.path(), error);
+  }
+}
+
+int main()
+{
+  cleanup();
+
+  Settings settings;
+  assert(settings.width.set(800) == StoreSettings::State::OK);
+  assert(settings.width.get()    == 800);
+
+  // The slot cached by the get points at the main file, the key now lives in a shard
+  settings.setSharding(StoreSettings::shardByHash(4));
+  assert(settings.width.get()    == 0);
+
+  assert(settings.width.set(1024) == StoreSettings::State::OK);
+  assert(settings.width.get()     == 1024);
+
+  settings.setSharding(nullptr);
+  assert(settings.width.get()    == 800);
+
+  // "net/http" and "net:http" are both written to store_sharding.net_http.json
+  settings.setSharding([](const std::string & key)
+  {
+    if(key.starts_with("http"))  return std::string("net/http");
+    if(key.starts_with("proxy")) return std::string("net:http");
+    return std::string();
+  });
+  assert(settings.timeout.set(30) == StoreSettings::State::OK);
+  assert(settings.port.set(8080)   == StoreSettings::State::OK);
+
+  const auto keys = settings.keys();
+  assert(std::find(keys.begin(), keys.end(), "http.timeout") != keys.end());
+  assert(std::find(keys.begin(), keys.end(), "proxy.port")   != keys.end());
+  assert(std::find(keys.begin(), keys.end(), "width")        != keys.end());
+  assert(settings.timeout.get() == 30);
+  assert(settings.port.get()    == 8080);
+
+  cleanup();
+
+  std::puts("OK");
+  return 0;
+}